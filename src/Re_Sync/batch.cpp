@@ -0,0 +1,426 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <fstream>
+#include <iostream>
+
+#include <boost/chrono.hpp>
+#include <boost/bind.hpp>
+
+#include "nullptr.h"
+#include "exception.h"
+#include "batch.h"
+#include "script.h"
+#include "index.h"
+#include "hash.h"
+#include "threadpool.h"
+
+#ifdef __GNUC__
+# include "unix/io.h"
+#else
+# include "windows/io.h"
+#endif
+
+
+typedef boost::chrono::steady_clock BatchClock;
+
+static std::wstring ErrorText(const std::exception& e)
+{
+	if ( std::wstring const* info = boost::get_error_info<error_message>(e) )
+	{
+		return *info;
+	}
+	const char* what = e.what();
+	return std::wstring(what, what + strlen(what));
+}
+
+/************************/
+/*   Чтение манифеста   */
+/************************/
+void ReadManifest(const std::string& filename, BatchJobs& jobs)
+{
+	std::ifstream fin(filename.c_str(), std::ios_base::binary);
+	if (!fin.is_open())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Can't open manifest"))
+			<< error_message(L"Ошибка открытия манифеста")
+		);
+	}
+
+	std::string line;
+	for (size_t number = 1; std::getline(fin, line); ++number)
+	{
+		if (number == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) line.erase(0, 3);
+		if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if (line.empty() || line[0] == '#') continue;
+
+		std::vector<std::string> fields;
+		for (size_t begin = 0;;)
+		{
+			size_t end = line.find('\t', begin);
+			fields.push_back( line.substr(begin, end == std::string::npos ? std::string::npos : end - begin) );
+			if (end == std::string::npos) break;
+			begin = end + 1;
+		}
+
+		if (fields.size() != 3 || fields[0].empty() || fields[1].empty() || fields[2].empty())
+		{
+			BOOST_THROW_EXCEPTION(
+				boost::enable_error_info(std::runtime_error("Wrong manifest line"))
+				<< error_message(L"Неправильная строка манифеста: " + std::to_wstring(static_cast<unsigned long long>(number)))
+			);
+		}
+		jobs.push_back( BatchJob(fields[0], fields[1], fields[2]) );
+	}
+}
+
+/***************************************/
+/*   Общий синхронизированный скрипт   */
+/***************************************/
+// Читается заранее, а разбирается и группируется первым заданием, которому не хватило кэша
+class BatchReference
+{
+public:
+	explicit BatchReference(const KeywordFilter& keywords) : script(keywords), hash(0), prepared(false), loaded(false), bytes(0) {};
+
+	SubtitleScript script;
+	PhraseGroups groups; // После загрузки только читаются
+	std::string filename, data;
+	unsigned long long hash;
+	bool prepared, loaded;
+	std::wstring error;
+	unsigned long long bytes;
+	boost::mutex mutex;
+};
+
+/*********************************/
+/*   Выполнение пакета заданий   */
+/*********************************/
+class BatchRunner
+{
+public:
+	BatchRunner(const KeywordFilter& keywords, unsigned long long keywords_hash, const SyncParams& params, const std::string& engine_name,
+		const EngineOptions& engine_options, const ResultCache* cache)
+		: _keywords(keywords), _keywords_hash(keywords_hash), _params(params), _engine_name(engine_name), _engine_options(engine_options), _cache(cache)
+	{
+		// Подробности сопоставления из параллельных заданий только перемешались бы
+		_engine_options.verbose = false;
+	}
+
+	void LoadReference(const std::string* filename, BatchReference* reference);
+	void RunJob(BatchJob* job, BatchReference* reference);
+
+private:
+	void PrepareReference(BatchReference* reference);
+	// true - результат взят из кэша
+	bool RunCached(BatchJob* job, const std::string& data, const CachedResult& cached);
+
+	const KeywordFilter& _keywords;
+	unsigned long long _keywords_hash;
+	const SyncParams& _params;
+	const std::string& _engine_name;
+	EngineOptions _engine_options;
+	const ResultCache* _cache;
+};
+
+void BatchRunner::LoadReference(const std::string* filename, BatchReference* reference)
+{
+	reference->filename = *filename;
+	try
+	{
+		io::ReadData(*filename, reference->data);
+		reference->bytes = reference->data.size();
+		if (_cache != nullptr)
+		{
+			// У индекса ключ кэша - хэш исходного текста, чтобы совпадать с самим скриптом.
+			// Проверяется сразу: иначе чужой индекс обнаружится только при промахе кэша.
+			ReferenceIndexHeader header;
+			if (IsReferenceIndex(*filename) && reference->data.size() >= sizeof(header))
+			{
+				std::memcpy(&header, reference->data.data(), sizeof(header));
+				CheckReferenceIndex(header, reference->data.size(), _params, _keywords_hash);
+				reference->hash = header.source_hash;
+			}
+			else
+			{
+				reference->hash = XXHash64(reference->data.data(), reference->data.size());
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		reference->error = ErrorText(e);
+		return;
+	}
+
+	// Без кэша группы понадобятся всем заданиям
+	if (_cache == nullptr) PrepareReference(reference);
+}
+
+void BatchRunner::PrepareReference(BatchReference* reference)
+{
+	boost::lock_guard<boost::mutex> lock(reference->mutex);
+	if (reference->prepared) return;
+	reference->prepared = true;
+	if ( !reference->error.empty() ) return;
+
+	try
+	{
+		if ( IsReferenceIndex(reference->filename) )
+		{
+			LoadReferenceIndex(reference->filename, _params, _keywords_hash, reference->groups);
+		}
+		else
+		{
+			std::wstring content;
+			io::Decode(reference->data.data(), reference->data.size(), content);
+			reference->script.Load(content);
+			reference->script.Group(_params, reference->groups);
+		}
+		reference->loaded = true;
+	}
+	catch (const std::exception& e)
+	{
+		reference->error = ErrorText(e);
+	}
+	catch (...)
+	{
+		reference->error = L"Неизвестная ошибка";
+	}
+	std::string().swap(reference->data);
+}
+
+bool BatchRunner::RunCached(BatchJob* job, const std::string& data, const CachedResult& cached)
+{
+	if (cached.in_sync)
+	{
+		job->in_sync = true;
+		return true;
+	}
+
+	std::wstring content;
+	io::Decode(data.data(), data.size(), content);
+	SubtitleScript script(_keywords);
+	script.Load(content);
+	ApplyPhraseShifts(script.getPhrases(), cached.shifts);
+
+	std::wstring out_content;
+	script.Generate(out_content);
+	io::WriteFile(job->out_name, out_content);
+	return true;
+}
+
+void BatchRunner::RunJob(BatchJob* job, BatchReference* reference)
+{
+	BatchClock::time_point start = BatchClock::now();
+	double compute_ms = 0.0;
+	try
+	{
+		{
+			// Ошибку может записать PrepareReference соседнего задания
+			boost::lock_guard<boost::mutex> lock(reference->mutex);
+			if ( !reference->error.empty() )
+			{
+				job->error = L"синхронизированный скрипт: " + reference->error;
+				return;
+			}
+		}
+
+		std::string data;
+		io::ReadData(job->desync_name, data);
+		job->bytes = data.size();
+
+		// При попадании в кэш не нужны ни группировка, ни сопоставление
+		unsigned long long key = 0;
+		if (_cache != nullptr)
+		{
+			key = _cache->Key(reference->hash, XXHash64(data.data(), data.size()));
+			CachedResult cached;
+			bool hit = false;
+			try
+			{
+				hit = _cache->Load(key, cached) && RunCached(job, data, cached);
+			}
+			catch (const std::exception&)
+			{
+				// Устаревшая или совпавшая по ключу чужая запись - считаем промахом и пересчитываем
+				hit = false;
+			}
+			if (hit)
+			{
+				job->cache_hit = true;
+				job->done = true;
+				compute_ms = cached.compute_ms;
+			}
+		}
+
+		if (!job->cache_hit)
+		{
+			PrepareReference(reference);
+			if (!reference->loaded)
+			{
+				job->error = L"синхронизированный скрипт: " + reference->error;
+				return;
+			}
+
+			SubtitleScript script(_keywords);
+			{
+				std::wstring content;
+				io::Decode(data.data(), data.size(), content);
+				script.Load(content);
+			}
+
+			BatchClock::time_point compute_start = BatchClock::now();
+			PhraseGroups groups;
+			script.Group(_params, groups);
+
+			// Группы общего скрипта алгоритмы сопоставления только читают,
+			// поэтому задания с одним скриптом идут параллельно без блокировок
+			AlignmentEnginePtr engine = CreateEngine(_engine_name, _engine_options);
+			DesyncGroups desync_points;
+			SegmentShifts shifts;
+			engine->Align(reference->groups, groups, _params, desync_points, shifts);
+			compute_ms = boost::chrono::duration<double, boost::milli>(BatchClock::now() - compute_start).count();
+
+			CachedResult result;
+			if (desync_points.empty())
+			{
+				job->in_sync = true;
+				result.in_sync = true;
+			}
+			else
+			{
+				PhraseGroups shifted;
+				script.Shift(groups, shifts, shifted);
+				std::wstring out_content;
+				script.Generate(out_content);
+				io::WriteFile(job->out_name, out_content);
+				if (_cache != nullptr) CollectPhraseShifts(shifted, result.shifts);
+			}
+
+			if (_cache != nullptr)
+			{
+				result.compute_ms = compute_ms;
+				_cache->Store(key, result);
+			}
+			job->done = true;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		job->error = ErrorText(e);
+	}
+	catch (...)
+	{
+		job->error = L"Неизвестная ошибка";
+	}
+	job->ms = boost::chrono::duration<double, boost::milli>(BatchClock::now() - start).count();
+	// Сэкономлено столько, сколько заняли группировка и сопоставление при заполнении кэша
+	if (job->cache_hit) job->saved_ms = compute_ms;
+}
+
+size_t RunBatch(BatchJobs& jobs, const KeywordFilter& keywords, unsigned long long keywords_hash, const SyncParams& params,
+	const std::string& engine_name, const EngineOptions& engine_options, const ResultCache* cache, bool verbose)
+{
+	BatchClock::time_point start = BatchClock::now();
+	BatchRunner runner(keywords, keywords_hash, params, engine_name, engine_options, cache);
+	ThreadPool pool;
+
+	// Синхронизированные скрипты без повторов
+	std::map<std::string, size_t> reference_index;
+	std::vector<const std::string*> reference_names;
+	std::vector< std::unique_ptr<BatchReference> > references;
+	std::vector<size_t> job_reference(jobs.size());
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		std::map<std::string, size_t>::iterator found = reference_index.find(jobs[i].sync_name);
+		if (found == reference_index.end())
+		{
+			found = reference_index.insert( std::make_pair(jobs[i].sync_name, references.size()) ).first;
+			reference_names.push_back(&found->first);
+			references.push_back( std::unique_ptr<BatchReference>(new BatchReference(keywords)) );
+		}
+		job_reference[i] = found->second;
+	}
+
+	if (verbose) std::wclog << L"Заданий: " << jobs.size() << L", синхронизированных скриптов: " << references.size()
+		<< L", потоков: " << pool.getSize() << std::endl;
+
+	for (size_t r = 0; r < references.size(); ++r)
+	{
+		pool.Submit( boost::bind(&BatchRunner::LoadReference, &runner, reference_names[r], references[r].get()) );
+	}
+	pool.Wait();
+
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		pool.Submit( boost::bind(&BatchRunner::RunJob, &runner, &jobs[i], references[job_reference[i]].get()) );
+	}
+	pool.Wait();
+
+	const double seconds = boost::chrono::duration<double>(BatchClock::now() - start).count();
+
+	// Итоги в порядке манифеста
+	size_t done = 0, in_sync = 0, failed = 0, hits = 0;
+	double saved_ms = 0.0;
+	unsigned long long bytes = 0;
+	for (size_t r = 0; r < references.size(); ++r)
+	{
+		bytes += references[r]->bytes;
+	}
+	for (BatchJobs::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+	{
+		bytes += it->bytes;
+		if (it->done)
+		{
+			++done;
+			if (it->in_sync) ++in_sync;
+			if (it->cache_hit)
+			{
+				++hits;
+				saved_ms += it->saved_ms;
+			}
+			if (verbose) std::wclog << L"  " << it->desync_name.c_str() << L": "
+				<< (it->in_sync ? L"синхронны" : L"готово") << (it->cache_hit ? L" (из кэша)" : L"")
+				<< L", " << static_cast<unsigned long long>(it->ms) << L" мс" << std::endl;
+		}
+		else
+		{
+			++failed;
+			std::wcerr << L"Ошибка: " << it->desync_name.c_str() << L": " << it->error << std::endl;
+		}
+	}
+
+	const double rate = seconds > 0.0 ? 1.0 / seconds : 0.0;
+	std::wclog << L"Заданий: " << jobs.size() << L", выполнено: " << done << L" (синхронны: " << in_sync << L")"
+		<< L", с ошибками: " << failed << std::endl
+		<< L"Время: " << seconds << L" с, файлов/с: " << jobs.size() * rate
+		<< L", МБ/с: " << static_cast<double>(bytes) / (1u << 20) * rate
+		<< L" (потоков: " << pool.getSize() << L", краж задач: " << pool.getStolen() << L")" << std::endl;
+	if (cache != nullptr)
+	{
+		std::wclog << L"Кэш: попаданий " << hits << L", промахов " << jobs.size() - failed - hits
+			<< L", сэкономлено " << saved_ms / 1000.0 << L" с" << std::endl;
+	}
+	return failed;
+}
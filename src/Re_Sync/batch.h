@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+#include "filter.h"
+#include "resync.h"
+#include "engine.h"
+#include "cache.h"
+
+
+/**************************************/
+/*   Задание пакетной синхронизации   */
+/**************************************/
+class BatchJob
+{
+public:
+	BatchJob(const std::string& sync_name, const std::string& desync_name, const std::string& out_name)
+		: sync_name(sync_name), desync_name(desync_name), out_name(out_name), done(false), in_sync(false), cache_hit(false),
+		bytes(0), ms(0.0), saved_ms(0.0) {};
+
+	std::string sync_name, desync_name, out_name;
+	bool done; // Выполнено без ошибок
+	bool in_sync; // Субтитры уже синхронны, вывод не записан
+	bool cache_hit; // Сдвиги взяты из кэша результатов
+	std::wstring error;
+	unsigned long long bytes; // Прочитано рассинхронизированного скрипта
+	double ms;
+	double saved_ms; // Время группировки и сопоставления, которое сэкономил кэш
+};
+
+typedef std::vector<BatchJob> BatchJobs;
+
+// Строка манифеста - синхронизированный, рассинхронизированный и выходной файлы через табуляцию.
+// Пустые строки и строки, начинающиеся с #, пропускаются.
+void ReadManifest(const std::string& filename, BatchJobs& jobs);
+
+// Задания выполняются на пуле потоков с кражей задач. Каждый синхронизированный скрипт
+// разбирается и группируется один раз, и его группы только читаются всеми заданиями.
+// Ошибка задания остаётся в BatchJob::error и не прерывает остальные.
+// С кэшем результатов (cache != nullptr) синхронизированный скрипт разбирается,
+// только если кэша не хватило хотя бы одному заданию. keywords_hash - как у индекса.
+// Возвращает число заданий с ошибками.
+size_t RunBatch(BatchJobs& jobs, const KeywordFilter& keywords, unsigned long long keywords_hash, const SyncParams& params,
+	const std::string& engine_name, const EngineOptions& engine_options, const ResultCache* cache, bool verbose);
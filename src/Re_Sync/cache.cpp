@@ -0,0 +1,227 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+
+#include <boost/cstdint.hpp>
+#include <boost/thread.hpp>
+
+#include "exception.h"
+#include "hash.h"
+#include "cache.h"
+
+#ifdef __GNUC__
+# include <sys/stat.h>
+# include <sys/types.h>
+#else
+# include <direct.h>
+#endif
+
+
+static const char CACHE_MAGIC[8] = {'R', 'E', 'S', 'Y', 'N', 'C', 'R', 'C'};
+static const boost::uint32_t CACHE_VERSION = 1;
+static const boost::uint32_t CACHE_IN_SYNC = 1;
+// Больше не бывает: время фраз укладывается в int, а сдвиг - разность времён
+static const boost::int32_t CACHE_MAX_SHIFT = std::numeric_limits<boost::int32_t>::max() / 2;
+
+struct CacheHeader
+{
+	char magic[8];
+	boost::uint32_t version;
+	boost::uint32_t flags;
+	boost::uint32_t count;
+	boost::uint32_t reserved;
+	boost::uint64_t key;
+	double compute_ms;
+};
+
+struct CacheRecord
+{
+	boost::uint32_t first, last;
+	boost::int32_t shift;
+};
+
+std::string ResultSettings(const SyncParams& params, const std::string& engine_name, const EngineOptions& engine_options,
+	unsigned long long salt)
+{
+	// От бюджета памяти зависит выбор алгоритма auto
+	std::ostringstream oss;
+	oss << params.min_duration << ' ' << params.max_offset << ' ' << params.max_desync << ' ' << params.max_shift << ' '
+		<< params.skip_lyrics << params.no_skip << params.allow_overlap << ' '
+		<< engine_name << ' ' << engine_options.memory_budget << ' ' << salt;
+	return oss.str();
+}
+
+ResultCache::ResultCache(const std::string& directory, const SyncParams& params, const std::string& engine_name,
+	const EngineOptions& engine_options, unsigned long long salt)
+	: _directory(directory)
+{
+#ifdef __GNUC__
+	const int made = mkdir(directory.c_str(), 0777);
+#else
+	const int made = _mkdir(directory.c_str());
+#endif
+	if (made != 0 && errno != EEXIST)
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Can't create cache directory"))
+			<< error_message(L"Ошибка создания каталога кэша")
+		);
+	}
+
+	_settings = ResultSettings(params, engine_name, engine_options, salt);
+}
+
+unsigned long long ResultCache::Key(unsigned long long sync_hash, unsigned long long desync_hash) const
+{
+	std::ostringstream oss;
+	oss << sync_hash << ' ' << desync_hash << ' ' << _settings;
+	const std::string key = oss.str();
+	return XXHash64(key.data(), key.size());
+}
+
+std::string ResultCache::FileName(unsigned long long key) const
+{
+	std::ostringstream oss;
+	oss << _directory << '/' << std::hex << std::setw(16) << std::setfill('0') << key << ".rsc";
+	return oss.str();
+}
+
+bool ResultCache::Load(unsigned long long key, CachedResult& result) const
+{
+	std::ifstream fin(FileName(key).c_str(), std::ios_base::binary);
+	if (!fin.is_open()) return false;
+
+	CacheHeader header;
+	if ( !fin.read(reinterpret_cast<char*>(&header), sizeof(header)) ) return false;
+	if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION || header.key != key) return false;
+
+	// Число записей сверяется с размером файла до выделения памяти под них
+	const std::streamoff records_begin = fin.tellg();
+	if ( !fin.seekg(0, std::ios_base::end) ) return false;
+	const std::streamoff records_size = fin.tellg() - records_begin;
+	if ( records_size != static_cast<std::streamoff>(header.count) * static_cast<std::streamoff>(sizeof(CacheRecord))
+		|| !fin.seekg(records_begin) ) return false;
+
+	std::vector<CacheRecord> records(header.count);
+	if ( !records.empty() && !fin.read(reinterpret_cast<char*>(&records[0]), records.size() * sizeof(records[0])) ) return false;
+
+	result.in_sync = (header.flags & CACHE_IN_SYNC) != 0;
+	result.compute_ms = header.compute_ms;
+	result.shifts.clear();
+	result.shifts.reserve(records.size());
+	for (std::vector<CacheRecord>::const_iterator it = records.begin(); it != records.end(); ++it)
+	{
+		if ( it->first > it->last || it->shift > CACHE_MAX_SHIFT || it->shift < -CACHE_MAX_SHIFT ) return false;
+		result.shifts.push_back( PhraseShift(it->first, it->last, it->shift) );
+	}
+	return true;
+}
+
+void ResultCache::Store(unsigned long long key, const CachedResult& result) const
+{
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.flags = result.in_sync ? CACHE_IN_SYNC : 0;
+	header.count = static_cast<boost::uint32_t>(result.shifts.size());
+	header.key = key;
+	header.compute_ms = result.compute_ms;
+
+	std::vector<CacheRecord> records(result.shifts.size());
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		records[i].first = static_cast<boost::uint32_t>(result.shifts[i].first);
+		records[i].last = static_cast<boost::uint32_t>(result.shifts[i].last);
+		records[i].shift = result.shifts[i].shift;
+	}
+
+	// Читатели видят либо старый файл, либо целиком записанный новый
+	const std::string filename = FileName(key);
+	std::ostringstream temp_name;
+	temp_name << filename << '.' << boost::this_thread::get_id() << ".tmp";
+	{
+		std::ofstream fout(temp_name.str().c_str(), std::ios_base::binary);
+		if (!fout.is_open()) return;
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (!records.empty()) fout.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(records[0]));
+		fout.close();
+		if (!fout)
+		{
+			std::remove(temp_name.str().c_str());
+			return;
+		}
+	}
+	if (std::rename(temp_name.str().c_str(), filename.c_str()) != 0)
+	{
+		std::remove(temp_name.str().c_str());
+	}
+}
+
+/*******************/
+/*   Сдвиги фраз   */
+/*******************/
+void CollectPhraseShifts(const PhraseGroups& result, PhraseShifts& shifts)
+{
+	shifts.clear();
+	for (PhraseGroups::const_iterator it = result.begin(); it != result.end(); ++it)
+	{
+		if (it->getShift() != 0)
+		{
+			shifts.push_back( PhraseShift(it->getFirstPhrase(), it->getFirstPhrase() + it->getPhraseCount(), it->getShift()) );
+		}
+	}
+}
+
+static unsigned int ShiftTime(unsigned int time, int shift)
+{
+	const long long temp = static_cast<long long>(time) + shift;
+	if (temp < 0) return 0u;
+	if (temp > std::numeric_limits<unsigned int>::max()) return std::numeric_limits<unsigned int>::max();
+	return static_cast<unsigned int>(temp);
+}
+
+void ApplyPhraseShifts(PhrasesPtrVector& pPhrases, const PhraseShifts& shifts)
+{
+	SortPhrases(pPhrases);
+	for (PhraseShifts::const_iterator it = shifts.begin(); it != shifts.end(); ++it)
+	{
+		if (it->last > pPhrases.size())
+		{
+			BOOST_THROW_EXCEPTION(
+				boost::enable_error_info(std::runtime_error("Cached shifts do not match the script"))
+				<< error_message(L"Сохранённые сдвиги не подходят к скрипту")
+			);
+		}
+		for (size_t i = it->first; i < it->last; ++i)
+		{
+			// Как PhraseGroup::applyShift, но без переполнения на чужих сдвигах
+			Phrase* pPhrase = pPhrases[i];
+			pPhrase->begin = ShiftTime(pPhrase->begin, it->shift);
+			pPhrase->end = ShiftTime(pPhrase->end, it->shift);
+		}
+	}
+}
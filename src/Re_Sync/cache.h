@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+#include "structure.h"
+#include "resync.h"
+#include "engine.h"
+
+
+/*******************************/
+/*   Сдвиг фраз одной группы   */
+/*******************************/
+class PhraseShift
+{
+public:
+	PhraseShift(size_t first, size_t last, int shift) : first(first), last(last), shift(shift) {};
+	size_t first, last; // Фразы [first, last) в порядке сортировки по времени
+	int shift;
+};
+typedef std::vector<PhraseShift> PhraseShifts;
+
+/*******************************************/
+/*   Сохранённый результат синхронизации   */
+/*******************************************/
+class CachedResult
+{
+public:
+	CachedResult() : in_sync(false), compute_ms(0.0) {};
+
+	bool in_sync;
+	PhraseShifts shifts;
+	double compute_ms; // Сколько заняли группировка и сопоставление
+};
+
+// Всё, кроме самих скриптов, от чего зависит результат синхронизации.
+// salt - хэш таблицы ключевых слов, 0 - встроенная.
+std::string ResultSettings(const SyncParams& params, const std::string& engine_name, const EngineOptions& engine_options,
+	unsigned long long salt);
+
+/***********************************************/
+/*   Кэш результатов по содержимому скриптов   */
+/***********************************************/
+// Ключ - xxHash обоих скриптов, параметров, алгоритма и таблицы ключевых слов.
+// Каждый результат лежит в отдельном файле каталога, запись атомарна, поэтому
+// кэшем могут одновременно пользоваться несколько заданий и процессов.
+class ResultCache
+{
+public:
+	// Каталог создаётся, если его нет. salt - как в ResultSettings.
+	ResultCache(const std::string& directory, const SyncParams& params, const std::string& engine_name,
+		const EngineOptions& engine_options, unsigned long long salt);
+
+	unsigned long long Key(unsigned long long sync_hash, unsigned long long desync_hash) const;
+	// false - нет в кэше или файл повреждён
+	bool Load(unsigned long long key, CachedResult& result) const;
+	// Ошибки записи не прерывают синхронизацию: результат просто не попадёт в кэш
+	void Store(unsigned long long key, const CachedResult& result) const;
+
+private:
+	std::string FileName(unsigned long long key) const;
+
+	std::string _directory;
+	std::string _settings; // Параметры, от которых зависит результат
+};
+
+// Сдвиги фраз по группам, полученным SubtitleScript::Shift
+void CollectPhraseShifts(const PhraseGroups& result, PhraseShifts& shifts);
+// Сортирует фразы, как группировка, и сдвигает их без группировки и сопоставления
+void ApplyPhraseShifts(PhrasesPtrVector& pPhrases, const PhraseShifts& shifts);
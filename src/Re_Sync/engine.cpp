@@ -0,0 +1,840 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+
+#include <boost/chrono.hpp>
+#include <boost/bind.hpp>
+
+#include "exception.h"
+#include "nullptr.h"
+#include "engine.h"
+#include "threadpool.h"
+
+
+// Алгоритмы, из которых выбирает "auto". Первый точный и выбирается всегда, когда
+// укладывается в бюджет памяти: остальные эвристические и могут дать другие сдвиги.
+static const char* const ENGINE_NAMES[] = {"lcs", "seed", "anchors"};
+static const size_t ENGINE_COUNT = sizeof(ENGINE_NAMES) / sizeof(ENGINE_NAMES[0]);
+
+// Алгоритмы, сравниваемые в --benchmark. Первый - эталон.
+// DTW оценивает пути иначе, чем НОП, поэтому "auto" его не выбирает
+static const char* const BENCHMARK_NAMES[] = {"lcs", "dtw", "seed", "anchors"};
+static const size_t BENCHMARK_COUNT = sizeof(BENCHMARK_NAMES) / sizeof(BENCHMARK_NAMES[0]);
+
+// Примерная стоимость одной ячейки таблицы НОП, в секундах
+static const double LCS_CELL_SECONDS = 2e-9;
+// Накладные расходы на строку таблицы: сам вектор и заголовок блока кучи
+static const unsigned long long ROW_OVERHEAD = sizeof(std::vector<unsigned int>) + 16u;
+// Примерная стоимость одной ячейки полосы DTW, в секундах
+static const double DTW_CELL_SECONDS = 1e-9;
+
+// Длина k-мера затравки, в группах
+static const size_t SEED_LENGTH = 4;
+// Затравки, встречающиеся чаще, считаются неоднозначными и пропускаются
+static const size_t MAX_SEED_HITS = 32;
+// Примерная стоимость поиска одной затравки, в секундах
+static const double SEED_SECONDS = 5e-8;
+// Накладные расходы хеш-индекса на одну позицию
+static const unsigned long long INDEX_ENTRY_OVERHEAD = 48u;
+// Типичная длина промежутка между цепочками совпадений, в группах
+static const unsigned long long TYPICAL_GAP = 32u;
+// Промежутки меньше этого числа ячеек НОП не стоит отдавать в пул потоков
+static const unsigned long long MIN_PARALLEL_CELLS = 1u << 16;
+// Примерная стоимость сортировки на один элемент, в секундах
+static const double SORT_SECONDS = 1e-8;
+// Примерная стоимость запуска одного потока пула, в секундах
+static const double THREAD_START_SECONDS = 5e-5;
+
+/******************************************************/
+/*   Цепочка совпадающих подряд групп двух скриптов   */
+/******************************************************/
+struct MatchRun
+{
+	size_t sync, desync, length;
+};
+typedef std::vector<MatchRun> MatchRuns;
+
+static bool MatchRunLonger(const MatchRun& first, const MatchRun& second)
+{
+	return first.length > second.length;
+}
+
+static size_t FindAnchors(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, MatchRuns& anchors);
+static void MeasureGaps(const MatchRuns& runs, AlignmentStats& stats);
+
+/********************************************/
+/*   Подсчёт характеристик входных данных   */
+/********************************************/
+AlignmentStats::AlignmentStats(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params)
+	: sync_count(sync.size()), desync_count(desync.size()), duration(0), max_shift(params.max_shift), density(0.0),
+	anchors(0), parallel_gaps(0), gap_cells(0), largest_gap_cells(0), largest_gap_rows(0)
+{
+	if (sync.empty() || desync.empty())
+	{
+		return;
+	}
+
+	duration = std::max(sync.back().getEnd(), desync.back().getEnd());
+
+	std::vector<int> offsets(desync.size());
+	for (size_t j = 0; j < desync.size(); ++j)
+	{
+		offsets[j] = static_cast<int>(desync[j].getOffset());
+	}
+	sort(offsets.begin(), offsets.end());
+
+	// Число пар, совпадающих с точностью до max_desync
+	unsigned long long matches = 0;
+	for (size_t i = 0; i < sync.size(); ++i)
+	{
+		int offset = static_cast<int>(sync[i].getOffset());
+		matches += std::upper_bound(offsets.begin(), offsets.end(), offset + params.max_desync)
+			- std::lower_bound(offsets.begin(), offsets.end(), offset - params.max_desync);
+	}
+
+	density = static_cast<double>(matches) / (static_cast<double>(sync_count) * static_cast<double>(desync_count));
+
+	// Оценить размер промежутков по плотности нельзя: всё решают немногие случайные совпадения
+	MatchRuns runs;
+	FindAnchors(sync, desync, params, runs);
+	anchors = runs.size();
+	MeasureGaps(runs, *this);
+}
+
+
+/***********/
+/*   НОП   */
+/***********/
+EngineCost LCSEngine::EstimateCost(const AlignmentStats& stats) const
+{
+	// Таблица max_len: (n+1)(m+1) ячеек по 4 байта плюс накладные расходы на каждую строку
+	unsigned long long rows = stats.sync_count + 1u, cols = stats.desync_count + 1u;
+	return EngineCost(
+		static_cast<double>(rows) * static_cast<double>(cols) * LCS_CELL_SECONDS,
+		rows * cols * sizeof(unsigned int) + rows * ROW_OVERHEAD
+	);
+}
+
+void LCSEngine::Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts)
+{
+	GetLCS(sync, desync, params, desync_points);
+	Syncronize(sync, desync, desync_points, params, shifts);
+}
+
+/***********/
+/*   DTW   */
+/***********/
+// Ширина полосы: сколько групп desync в среднем укладывается в окно ±max_shift
+static size_t EstimateBand(const AlignmentStats& stats)
+{
+	if (stats.duration == 0)
+	{
+		return stats.desync_count;
+	}
+	unsigned long long band = static_cast<unsigned long long>(stats.desync_count) * 2u * static_cast<unsigned int>(stats.max_shift) / stats.duration + 1u;
+	return static_cast<size_t>(std::min<unsigned long long>(band, stats.desync_count));
+}
+
+EngineCost DTWEngine::EstimateCost(const AlignmentStats& stats) const
+{
+	// Две строки стоимостей и временные массивы на ширину полосы, направления на всю полосу
+	unsigned long long band = EstimateBand(stats), cells = band * stats.sync_count;
+	return EngineCost(
+		static_cast<double>(cells) * DTW_CELL_SECONDS,
+		cells + band * 5u * sizeof(float) + stats.sync_count * 3u * sizeof(size_t)
+	);
+}
+
+void DTWEngine::Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts)
+{
+	if (sync.empty() || desync.empty())
+	{
+		return;
+	}
+
+	enum {STEP_DIAG, STEP_UP, STEP_LEFT};
+	const float INF = std::numeric_limits<float>::max();
+	const float CAP = static_cast<float>(params.max_shift);
+	const size_t n = sync.size(), m = desync.size();
+
+	// Признаки групп: отступ от предыдущей и длительность
+	std::vector<float> sync_offset(n), sync_duration(n), desync_offset(m), desync_duration(m);
+	for (size_t i = 0; i < n; ++i)
+	{
+		sync_offset[i] = static_cast<float>(sync[i].getOffset());
+		sync_duration[i] = static_cast<float>(sync[i].getEnd() - sync[i].getBegin());
+	}
+	for (size_t j = 0; j < m; ++j)
+	{
+		desync_offset[j] = static_cast<float>(desync[j].getOffset());
+		desync_duration[j] = static_cast<float>(desync[j].getEnd() - desync[j].getBegin());
+	}
+
+	// Полоса строки i - группы desync, начало которых отстоит не дальше max_shift.
+	// Границы не убывают, а соседние строки перекрываются, иначе путь прервётся.
+	std::vector<size_t> lo(n), hi(n), row_start(n + 1, 0);
+	size_t band = 0;
+	{
+		size_t l = 0, h = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			int begin = static_cast<int>(sync[i].getBegin());
+			while (l < m - 1 && begin - static_cast<int>(desync[l].getBegin()) > params.max_shift) ++l;
+			while (h < m - 1 && static_cast<int>(desync[h + 1].getBegin()) - begin <= params.max_shift) ++h;
+
+			if (i == 0)
+			{
+				lo[i] = 0;
+				hi[i] = std::max(h, l);
+			}
+			else
+			{
+				lo[i] = std::max(lo[i - 1], std::min(l, hi[i - 1]));
+				hi[i] = std::max(hi[i - 1], std::max(h, lo[i]));
+			}
+			if (i == n - 1) hi[i] = m - 1;
+
+			row_start[i + 1] = row_start[i] + (hi[i] - lo[i] + 1);
+			band = std::max(band, hi[i] - lo[i] + 1);
+		}
+	}
+
+	// Стоимости - только две строки, направления шагов - на всю полосу
+	std::vector<float> prev(band), cur(band), ext(band + 1), local(band), step_cost(band);
+	std::vector<unsigned char> steps(row_start[n]);
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		const size_t width = hi[i] - lo[i] + 1;
+		const float* d_offset = &desync_offset[lo[i]];
+		const float* d_duration = &desync_duration[lo[i]];
+		unsigned char* row_steps = &steps[row_start[i]];
+
+		// Локальная стоимость на всю ширину полосы
+		for (size_t k = 0; k < width; ++k)
+		{
+			local[k] = std::min(std::abs(sync_offset[i] - d_offset[k]), CAP) + std::min(std::abs(sync_duration[i] - d_duration[k]), CAP);
+		}
+
+		// Предыдущая строка в координатах текущей: ext[k] = D(i-1, lo+k-1)
+		std::fill(ext.begin(), ext.begin() + width + 1, INF);
+		if (i == 0)
+		{
+			ext[0] = 0.0f; // Вход в (0, 0)
+		}
+		else
+		{
+			size_t from = std::max(lo[i], lo[i - 1] + 1) - 1, to = std::min(hi[i], hi[i - 1]);
+			for (size_t j = from; j <= to; ++j)
+			{
+				ext[j + 1 - lo[i]] = prev[j - lo[i - 1]];
+			}
+		}
+
+		// Шаг по диагонали или сверху на всю ширину полосы
+		for (size_t k = 0; k < width; ++k)
+		{
+			bool diag = ext[k] <= ext[k + 1];
+			step_cost[k] = diag ? ext[k] : ext[k + 1];
+			row_steps[k] = diag ? STEP_DIAG : STEP_UP;
+		}
+
+		// Шаг слева - последовательная зависимость внутри строки
+		float left = INF;
+		for (size_t k = 0; k < width; ++k)
+		{
+			float best = step_cost[k];
+			if (left < best)
+			{
+				best = left;
+				row_steps[k] = STEP_LEFT;
+			}
+			left = best == INF ? INF : best + local[k];
+			cur[k] = left;
+		}
+		prev.swap(cur);
+	}
+
+	// Обратный проход по направлениям
+	std::vector< std::pair<size_t, size_t> > path;
+	{
+		size_t i = n - 1, j = m - 1;
+		for (;;)
+		{
+			path.push_back(std::make_pair(i, j));
+			if (i == 0 && j == 0) break;
+
+			unsigned char step = steps[row_start[i] + (j - lo[i])];
+			if (step == STEP_DIAG)
+			{
+				--i;
+				--j;
+			}
+			else if (step == STEP_UP)
+			{
+				--i;
+			}
+			else
+			{
+				--j;
+			}
+		}
+	}
+	std::reverse(path.begin(), path.end());
+
+	// Точки рассинхронизации в той же форме, что и у НОП
+	DesyncPositions syncAccum, desyncAccum;
+	for (size_t k = 0; k < path.size(); ++k)
+	{
+		size_t i = path[k].first, j = path[k].second;
+		bool new_i = k == 0 || i != path[k - 1].first;
+		bool new_j = k == 0 || j != path[k - 1].second;
+
+		if ( new_i && new_j && abs(static_cast<int>(sync[i].getOffset()) - static_cast<int>(desync[j].getOffset())) <= params.max_desync )
+		{
+			if (!syncAccum.empty() && !desyncAccum.empty())
+			{
+				desync_points.push_back( DesyncGroup(syncAccum, desyncAccum) );
+			}
+			syncAccum.clear();
+			desyncAccum.clear();
+		}
+		else
+		{
+			if (new_i) syncAccum.push_back(i);
+			if (new_j) desyncAccum.push_back(j);
+		}
+	}
+
+	Syncronize(sync, desync, desync_points, params, shifts);
+}
+
+/*****************************************************/
+/*   Досчёт промежутков между цепочками совпадений   */
+/*****************************************************/
+// Промежуток для НОП; flush_tail - за ним следует цепочка совпадений
+struct Gap
+{
+	size_t sync_begin, sync_end, desync_begin, desync_end;
+	bool flush_tail;
+
+	unsigned long long getCells() const
+	{
+		return static_cast<unsigned long long>(sync_end - sync_begin + 1) * (desync_end - desync_begin + 1);
+	}
+};
+
+static void AlignGap(PhraseGroups* sync, PhraseGroups* desync, const Gap* gap, const SyncParams* params, DesyncGroups* result)
+{
+	GetLCS(*sync, gap->sync_begin, gap->sync_end, *desync, gap->desync_begin, gap->desync_end, gap->flush_tail, *params, *result);
+}
+
+static void CollectGaps(const MatchRuns& runs, size_t sync_count, size_t desync_count, std::vector<Gap>& gaps)
+{
+	size_t sync_pos = 0, desync_pos = 0;
+	for (MatchRuns::const_iterator it = runs.begin(); it != runs.end(); ++it)
+	{
+		Gap gap = {sync_pos, it->sync, desync_pos, it->desync, true};
+		gaps.push_back(gap);
+
+		sync_pos = it->sync + it->length;
+		desync_pos = it->desync + it->length;
+	}
+	Gap tail = {sync_pos, sync_count, desync_pos, desync_count, false};
+	gaps.push_back(tail);
+}
+
+static void MeasureGaps(const MatchRuns& runs, AlignmentStats& stats)
+{
+	std::vector<Gap> gaps;
+	CollectGaps(runs, stats.sync_count, stats.desync_count, gaps);
+	for (std::vector<Gap>::const_iterator it = gaps.begin(); it != gaps.end(); ++it)
+	{
+		unsigned long long cells = it->getCells();
+		stats.gap_cells += cells;
+		if (cells >= MIN_PARALLEL_CELLS) ++stats.parallel_gaps;
+		if (cells > stats.largest_gap_cells)
+		{
+			stats.largest_gap_cells = cells;
+			stats.largest_gap_rows = it->sync_end - it->sync_begin + 1;
+		}
+	}
+}
+
+// Цепочки должны идти по возрастанию в обоих скриптах и не пересекаться.
+// С пулом потоков крупные промежутки считаются параллельно, результаты склеиваются по порядку.
+// Возвращает число ячеек, посчитанных НОП, и размер самой большой таблицы.
+static unsigned long long AlignGaps(PhraseGroups& sync, PhraseGroups& desync, const MatchRuns& runs, const SyncParams& params, DesyncGroups& desync_points,
+	ThreadPool* pool = nullptr, unsigned long long* largest = nullptr)
+{
+	std::vector<Gap> gaps;
+	CollectGaps(runs, sync.size(), desync.size(), gaps);
+
+	std::vector<DesyncGroups> parts(gaps.size());
+	unsigned long long cells = 0, max_cells = 0;
+	for (size_t k = 0; k < gaps.size(); ++k)
+	{
+		unsigned long long gap_cells = gaps[k].getCells();
+		cells += gap_cells;
+		max_cells = std::max(max_cells, gap_cells);
+
+		if (pool != nullptr && gap_cells >= MIN_PARALLEL_CELLS)
+		{
+			pool->Submit(boost::bind(&AlignGap, &sync, &desync, &gaps[k], &params, &parts[k]));
+		}
+		else
+		{
+			AlignGap(&sync, &desync, &gaps[k], &params, &parts[k]);
+		}
+	}
+	if (pool != nullptr) pool->Wait();
+
+	for (size_t k = 0; k < parts.size(); ++k)
+	{
+		desync_points.insert(desync_points.end(), parts[k].begin(), parts[k].end());
+	}
+
+	if (largest != nullptr) *largest = max_cells;
+	return cells;
+}
+
+/*****************************************/
+/*   Затравки по k-мерам с расширением   */
+/*****************************************/
+static inline bool OffsetsMatch(PhraseGroup& first, PhraseGroup& second, int max_desync)
+{
+	return abs(static_cast<int>(first.getOffset()) - static_cast<int>(second.getOffset())) <= max_desync;
+}
+
+// FNV-1a по SEED_LENGTH квантованным отступам
+static unsigned long long KmerHash(const std::vector<unsigned int>& buckets, size_t pos)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t k = 0; k < SEED_LENGTH; ++k)
+	{
+		hash = (hash ^ buckets[pos + k]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+EngineCost SeedExtendEngine::EstimateCost(const AlignmentStats& stats) const
+{
+	// Попаданий на затравку при случайных отступах ~ n * density^k, но не больше MAX_SEED_HITS
+	double hits = static_cast<double>(stats.sync_count);
+	for (size_t k = 0; k < SEED_LENGTH; ++k) hits *= stats.density;
+	hits = std::min(hits, static_cast<double>(MAX_SEED_HITS));
+
+	unsigned long long groups = stats.sync_count + stats.desync_count;
+	return EngineCost(
+		static_cast<double>(groups) * SEED_SECONDS * (1.0 + hits) + static_cast<double>(groups * TYPICAL_GAP) * LCS_CELL_SECONDS,
+		stats.sync_count * (sizeof(size_t) + INDEX_ENTRY_OVERHEAD) + TYPICAL_GAP * TYPICAL_GAP * sizeof(unsigned int)
+	);
+}
+
+void SeedExtendEngine::Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts)
+{
+	const size_t n = sync.size(), m = desync.size();
+	if (n < SEED_LENGTH || m < SEED_LENGTH)
+	{
+		GetLCS(sync, desync, params, desync_points);
+		Syncronize(sync, desync, desync_points, params, shifts);
+		return;
+	}
+
+	// Квантование отступов: в одной корзине отступы заведомо совпадают с точностью до max_desync
+	const unsigned int bucket = params.max_desync > 0 ? static_cast<unsigned int>(params.max_desync) : 1u;
+	std::vector<unsigned int> sync_buckets(n), desync_buckets(m);
+	for (size_t i = 0; i < n; ++i) sync_buckets[i] = sync[i].getOffset() / bucket;
+	for (size_t j = 0; j < m; ++j) desync_buckets[j] = desync[j].getOffset() / bucket;
+
+	// Индекс k-меров синхронизированного скрипта
+	std::unordered_map< unsigned long long, std::vector<size_t> > index;
+	index.reserve(n);
+	for (size_t i = 0; i + SEED_LENGTH <= n; ++i)
+	{
+		index[KmerHash(sync_buckets, i)].push_back(i);
+	}
+
+	// Поиск затравок и расширение в обе стороны
+	MatchRuns runs;
+	std::unordered_map<long long, size_t> covered; // Диагональ -> до какой группы desync уже покрыта
+	unsigned long long seeds = 0, hits = 0, ambiguous = 0, extended = 0;
+	for (size_t j = 0; j + SEED_LENGTH <= m; ++j)
+	{
+		++seeds;
+		std::unordered_map< unsigned long long, std::vector<size_t> >::const_iterator found = index.find(KmerHash(desync_buckets, j));
+		if (found == index.end()) continue;
+		if (found->second.size() > MAX_SEED_HITS)
+		{
+			++ambiguous;
+			continue;
+		}
+
+		for (std::vector<size_t>::const_iterator it = found->second.begin(); it != found->second.end(); ++it)
+		{
+			const size_t i = *it;
+			const long long diagonal = static_cast<long long>(i) - static_cast<long long>(j);
+			std::unordered_map<long long, size_t>::const_iterator cover = covered.find(diagonal);
+			if (cover != covered.end() && cover->second > j) continue;
+			if (!std::equal(sync_buckets.begin() + i, sync_buckets.begin() + i + SEED_LENGTH, desync_buckets.begin() + j)) continue;
+			++hits;
+
+			size_t sync_begin = i, desync_begin = j, sync_end = i, desync_end = j;
+			while (sync_begin > 0 && desync_begin > 0 && OffsetsMatch(sync[sync_begin - 1], desync[desync_begin - 1], params.max_desync))
+			{
+				--sync_begin;
+				--desync_begin;
+			}
+			while (sync_end < n && desync_end < m && OffsetsMatch(sync[sync_end], desync[desync_end], params.max_desync))
+			{
+				++sync_end;
+				++desync_end;
+			}
+
+			MatchRun run = {sync_begin, desync_begin, sync_end - sync_begin};
+			runs.push_back(run);
+			covered[diagonal] = desync_end;
+			extended += run.length;
+		}
+	}
+
+	// Самые длинные цепочки в первую очередь, если они не противоречат уже выбранным
+	std::stable_sort(runs.begin(), runs.end(), MatchRunLonger);
+	std::map<size_t, MatchRun> chain;
+	for (MatchRuns::const_iterator it = runs.begin(); it != runs.end(); ++it)
+	{
+		std::map<size_t, MatchRun>::iterator next = chain.lower_bound(it->sync);
+		if (next != chain.end() && (it->sync + it->length > next->second.sync || it->desync + it->length > next->second.desync)) continue;
+		if (next != chain.begin())
+		{
+			std::map<size_t, MatchRun>::iterator prev = next;
+			--prev;
+			if (prev->second.sync + prev->second.length > it->sync || prev->second.desync + prev->second.length > it->desync) continue;
+		}
+		chain.insert(next, std::make_pair(it->sync, *it));
+	}
+
+	MatchRuns chosen;
+	size_t chained = 0;
+	for (std::map<size_t, MatchRun>::const_iterator it = chain.begin(); it != chain.end(); ++it)
+	{
+		chosen.push_back(it->second);
+		chained += it->second.length;
+	}
+
+	unsigned long long cells = AlignGaps(sync, desync, chosen, params, desync_points);
+
+	if (_verbose)
+	{
+		std::wclog << L"Затравок: " << seeds << L", попаданий: " << hits << L", неоднозначных: " << ambiguous << std::endl
+			<< L"Цепочек: " << runs.size() << L" (" << extended << L" групп), выбрано: " << chosen.size()
+			<< L" (" << chained << L" групп)" << std::endl
+			<< L"Ячеек НОП в промежутках: " << cells << L" из " << static_cast<unsigned long long>(n + 1) * (m + 1) << std::endl;
+	}
+
+	Syncronize(sync, desync, desync_points, params, shifts);
+}
+
+/********************************************/
+/*   Разбиение по однозначным совпадениям   */
+/********************************************/
+typedef std::vector< std::pair<int, size_t> > SortedOffsets;
+
+static void SortOffsets(PhraseGroups& groups, SortedOffsets& sorted)
+{
+	sorted.resize(groups.size());
+	for (size_t i = 0; i < groups.size(); ++i)
+	{
+		sorted[i] = std::make_pair(static_cast<int>(groups[i].getOffset()), i);
+	}
+	sort(sorted.begin(), sorted.end());
+}
+
+// Диапазон отсортированных отступов, совпадающих с offset с точностью до max_desync
+static std::pair<SortedOffsets::const_iterator, SortedOffsets::const_iterator> MatchingOffsets(const SortedOffsets& sorted, int offset, int max_desync)
+{
+	return std::make_pair(
+		std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(offset - max_desync, static_cast<size_t>(0))),
+		std::upper_bound(sorted.begin(), sorted.end(), std::make_pair(offset + max_desync, static_cast<size_t>(-1)))
+	);
+}
+
+// Пары групп, совпадающие только друг с другом, в возрастающем по обоим скриптам порядке
+static size_t FindAnchors(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, MatchRuns& anchors)
+{
+	SortedOffsets sync_sorted, desync_sorted;
+	SortOffsets(sync, sync_sorted);
+	SortOffsets(desync, desync_sorted);
+
+	MatchRuns candidates;
+	for (size_t i = 0; i < sync.size(); ++i)
+	{
+		std::pair<SortedOffsets::const_iterator, SortedOffsets::const_iterator> found = MatchingOffsets(desync_sorted, static_cast<int>(sync[i].getOffset()), params.max_desync);
+		if (found.second - found.first != 1) continue;
+
+		size_t j = found.first->second;
+		std::pair<SortedOffsets::const_iterator, SortedOffsets::const_iterator> back = MatchingOffsets(sync_sorted, static_cast<int>(desync[j].getOffset()), params.max_desync);
+		if (back.second - back.first != 1) continue;
+
+		MatchRun anchor = {i, j, 1};
+		candidates.push_back(anchor);
+	}
+
+	// Наибольшая возрастающая по desync подпоследовательность кандидатов
+	std::vector<size_t> tails, parent(candidates.size(), static_cast<size_t>(-1));
+	for (size_t k = 0; k < candidates.size(); ++k)
+	{
+		size_t lo = 0, hi = tails.size();
+		while (lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			if (candidates[tails[mid]].desync < candidates[k].desync) lo = mid + 1;
+			else hi = mid;
+		}
+		if (lo > 0) parent[k] = tails[lo - 1];
+		if (lo == tails.size()) tails.push_back(k);
+		else tails[lo] = k;
+	}
+
+	anchors.resize(tails.size());
+	for (size_t k = tails.empty() ? 0 : tails.back(), pos = tails.size(); pos > 0; k = parent[k])
+	{
+		anchors[--pos] = candidates[k];
+	}
+
+	return candidates.size();
+}
+
+EngineCost AnchorEngine::EstimateCost(const AlignmentStats& stats) const
+{
+	// Промежутки измерены в AlignmentStats. Одновременно в памяти таблицы крупных промежутков
+	// по числу потоков и таблица мелкого, который текущий поток считает сам.
+	// На потоке пула промежутки считаются последовательно, как в Align.
+	double groups = static_cast<double>(std::max(stats.sync_count, stats.desync_count));
+	unsigned long long threads = ThreadPool::InWorker() ? 1u : std::max(1u, boost::thread::hardware_concurrency());
+	unsigned long long tables = std::min<unsigned long long>(threads, stats.parallel_gaps);
+	unsigned long long small_cells = std::min(stats.largest_gap_cells, MIN_PARALLEL_CELLS);
+
+	return EngineCost(
+		threads * THREAD_START_SECONDS + groups * std::log(groups + 1.0) * SORT_SECONDS
+			+ static_cast<double>(stats.gap_cells) * LCS_CELL_SECONDS / std::max(1ull, tables),
+		tables * (stats.largest_gap_cells * sizeof(unsigned int) + stats.largest_gap_rows * ROW_OVERHEAD)
+			+ small_cells * sizeof(unsigned int) + std::min(stats.largest_gap_rows, small_cells) * ROW_OVERHEAD
+			+ static_cast<unsigned long long>(groups) * 2u * sizeof(SortedOffsets::value_type)
+	);
+}
+
+AnchorEngine::AnchorEngine(bool verbose) : _verbose(verbose)
+{
+}
+
+AnchorEngine::~AnchorEngine()
+{
+}
+
+void AnchorEngine::Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts)
+{
+	MatchRuns anchors;
+	size_t candidates = FindAnchors(sync, desync, params, anchors);
+
+	// В --auto-tune и --batch сопоставления уже идут на пуле: промежутки считаются в том же потоке
+	ThreadPool* pool = nullptr;
+	if ( !ThreadPool::InWorker() )
+	{
+		if (!_pool) _pool.reset(new ThreadPool);
+		pool = _pool.get();
+	}
+	unsigned long long largest = 0;
+	unsigned long long cells = AlignGaps(sync, desync, anchors, params, desync_points, pool, &largest);
+
+	if (_verbose)
+	{
+		std::wclog << L"Однозначных совпадений: " << candidates << L", опорных: " << anchors.size()
+			<< L", потоков: " << (pool != nullptr ? pool->getSize() : 1u) << std::endl
+			<< L"Ячеек НОП: " << cells << L" из " << static_cast<unsigned long long>(sync.size() + 1) * (desync.size() + 1)
+			<< L", наибольшая таблица: " << ((largest * sizeof(unsigned int)) >> 10) << L" КБ" << std::endl;
+	}
+
+	Syncronize(sync, desync, desync_points, params, shifts);
+}
+
+/****************************/
+/*   Автоматический выбор   */
+/****************************/
+AutoEngine::AutoEngine(const EngineOptions& options) : _options(options)
+{
+	for (size_t i = 0; i < ENGINE_COUNT; ++i)
+	{
+		_engines.push_back( CreateEngine(ENGINE_NAMES[i], _options) );
+	}
+}
+
+AlignmentEngine* AutoEngine::Select(const AlignmentStats& stats) const
+{
+	AlignmentEngine* best = nullptr;
+	AlignmentEngine* smallest = nullptr;
+	double best_seconds = 0.0;
+	unsigned long long smallest_bytes = 0;
+
+	for (size_t i = 0; i < _engines.size(); ++i)
+	{
+		AlignmentEngine* engine = _engines[i].get();
+		EngineCost cost = engine->EstimateCost(stats);
+
+		if (_options.verbose)
+		{
+			std::wclog << L"  " << engine->getName() << L": время ~" << static_cast<unsigned long long>(cost.seconds * 1000.0)
+				<< L" мс, память ~" << (cost.bytes >> 10) << L" КБ"
+				<< (cost.bytes > _options.memory_budget ? L" (превышает бюджет)" : L"") << std::endl;
+		}
+
+		// Быстрее точного - не повод менять результат
+		if (cost.bytes <= _options.memory_budget && i == 0)
+		{
+			best = engine;
+			break;
+		}
+		if (cost.bytes <= _options.memory_budget && (best == nullptr || cost.seconds < best_seconds))
+		{
+			best_seconds = cost.seconds;
+			best = engine;
+		}
+		else if (smallest == nullptr || cost.bytes < smallest_bytes)
+		{
+			smallest_bytes = cost.bytes;
+			smallest = engine;
+		}
+	}
+
+	if (best == nullptr)
+	{
+		std::wclog << L"Ни один алгоритм не укладывается в бюджет памяти, выбран наименее требовательный" << std::endl;
+		best = smallest;
+	}
+
+	return best;
+}
+
+EngineCost AutoEngine::EstimateCost(const AlignmentStats& stats) const
+{
+	return Select(stats)->EstimateCost(stats);
+}
+
+void AutoEngine::Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts)
+{
+	AlignmentStats stats(sync, desync, params);
+	if (_options.verbose)
+	{
+		std::wclog << L"Групп: " << stats.sync_count << L" x " << stats.desync_count
+			<< L", плотность совпадений: " << stats.density << std::endl;
+	}
+
+	AlignmentEngine* engine = Select(stats);
+	if (_options.verbose) std::wclog << L"Выбран алгоритм: " << engine->getName() << std::endl;
+
+	engine->Align(sync, desync, params, desync_points, shifts);
+}
+
+/**************************************/
+/*   Создание алгоритма по названию   */
+/**************************************/
+AlignmentEnginePtr CreateEngine(const std::string& name, const EngineOptions& options)
+{
+	if (name == "auto")
+	{
+		return AlignmentEnginePtr(new AutoEngine(options));
+	}
+	if (name == "lcs")
+	{
+		return AlignmentEnginePtr(new LCSEngine);
+	}
+	if (name == "dtw")
+	{
+		return AlignmentEnginePtr(new DTWEngine);
+	}
+	if (name == "seed")
+	{
+		return AlignmentEnginePtr(new SeedExtendEngine(options.verbose));
+	}
+	if (name == "anchors")
+	{
+		return AlignmentEnginePtr(new AnchorEngine(options.verbose));
+	}
+
+	BOOST_THROW_EXCEPTION(
+		boost::enable_error_info(std::runtime_error("Unknown alignment engine"))
+		<< error_message(L"Неизвестный алгоритм сопоставления")
+	);
+}
+
+/*************************************/
+/*   Сравнение алгоритмов на входе   */
+/*************************************/
+void BenchmarkEngines(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params)
+{
+	typedef boost::chrono::steady_clock clock;
+
+	AlignmentStats stats(sync, desync, params);
+	std::vector<int> reference_shifts;
+
+	std::wclog << L"Сравнение алгоритмов (групп " << stats.sync_count << L" x " << stats.desync_count << L"):" << std::endl;
+	for (size_t e = 0; e < BENCHMARK_COUNT; ++e)
+	{
+		AlignmentEnginePtr engine = CreateEngine(BENCHMARK_NAMES[e]);
+		EngineCost cost = engine->EstimateCost(stats);
+
+		DesyncGroups desync_points;
+		SegmentShifts shifts;
+		clock::time_point start = clock::now();
+		engine->Align(sync, desync, params, desync_points, shifts);
+		double ms = boost::chrono::duration<double, boost::milli>(clock::now() - start).count();
+
+		// Сдвиг каждой группы; без точек рассинхронизации всё остаётся на месте
+		std::vector<int> group_shifts(desync.size(), 0);
+		for (SegmentShifts::iterator it = shifts.begin(); it != shifts.end(); ++it)
+		{
+			std::fill(group_shifts.begin() + it->begin, group_shifts.begin() + it->end, it->shift);
+		}
+		if (e == 0) reference_shifts = group_shifts;
+
+		PhraseGroups result;
+		ApplyShifts(desync, shifts, result);
+		unsigned int matched = CountSyncronized(sync, shifts.empty() ? desync : result, params);
+
+		size_t agree = 0;
+		for (size_t j = 0; j < group_shifts.size(); ++j)
+		{
+			if (group_shifts[j] == reference_shifts[j]) ++agree;
+		}
+
+		std::wclog << L"  " << engine->getName() << L": " << static_cast<unsigned long long>(ms * 1000.0) << L" мкс"
+			<< L", оценка памяти " << (cost.bytes >> 10) << L" КБ"
+			<< L", точек " << desync_points.size()
+			<< L", совпало групп " << matched << L"/" << std::min(stats.sync_count, stats.desync_count)
+			<< L", сдвиги как у " << BENCHMARK_NAMES[0] << L": " << agree << L"/" << desync.size() << std::endl;
+	}
+}
@@ -0,0 +1,146 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "resync.h"
+
+class ThreadPool;
+
+
+/*************************************/
+/*   Характеристики входных данных   */
+/*************************************/
+class AlignmentStats
+{
+public:
+	AlignmentStats(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params);
+
+	size_t sync_count, desync_count;
+	unsigned int duration; // Конец последней группы
+	int max_shift;
+	double density; // Доля пар групп с совпадающими отступами
+	// Промежутки между опорными однозначными совпадениями, как у AnchorEngine
+	size_t anchors, parallel_gaps; // parallel_gaps - промежутки, которые считаются на пуле
+	unsigned long long gap_cells, largest_gap_cells, largest_gap_rows;
+};
+
+/**********************************/
+/*   Оценка стоимости алгоритма   */
+/**********************************/
+class EngineCost
+{
+public:
+	EngineCost(double seconds, unsigned long long bytes) : seconds(seconds), bytes(bytes) {};
+	double seconds;
+	unsigned long long bytes;
+};
+
+/*********************************************/
+/*   Базовый класс алгоритма сопоставления   */
+/*********************************************/
+class AlignmentEngine
+{
+public:
+	virtual ~AlignmentEngine() {};
+
+	virtual const char* getName() const = 0;
+
+	// Оценка времени и памяти без запуска
+	virtual EngineCost EstimateCost(const AlignmentStats& stats) const = 0;
+
+	// Поиск точек рассинхронизации и сдвигов участков между ними
+	virtual void Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts) = 0;
+};
+
+typedef std::unique_ptr<AlignmentEngine> AlignmentEnginePtr;
+
+/**********************************************************/
+/*   Эталонный алгоритм: НОП по отступам между группами   */
+/**********************************************************/
+class LCSEngine : public AlignmentEngine
+{
+public:
+	const char* getName() const { return "lcs"; }
+	EngineCost EstimateCost(const AlignmentStats& stats) const;
+	void Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts);
+};
+
+/**************************************************************/
+/*   Динамическая трансформация времени в полосе Сакоэ-Тибы   */
+/**************************************************************/
+class DTWEngine : public AlignmentEngine
+{
+public:
+	const char* getName() const { return "dtw"; }
+	EngineCost EstimateCost(const AlignmentStats& stats) const;
+	void Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts);
+};
+
+/**************************************************************************/
+/*   Затравки по хешам k-меров отступов, расширение и НОП в промежутках   */
+/**************************************************************************/
+class SeedExtendEngine : public AlignmentEngine
+{
+	bool _verbose;
+
+public:
+	SeedExtendEngine(bool verbose = false) : _verbose(verbose) {};
+
+	const char* getName() const { return "seed"; }
+	EngineCost EstimateCost(const AlignmentStats& stats) const;
+	void Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts);
+};
+
+/*****************************************************************************/
+/*   Разбиение по однозначным совпадениям и параллельная НОП в промежутках   */
+/*****************************************************************************/
+class AnchorEngine : public AlignmentEngine
+{
+	bool _verbose;
+	std::unique_ptr<ThreadPool> _pool; // Создаётся при первом сопоставлении и служит всем следующим
+
+public:
+	AnchorEngine(bool verbose = false);
+	~AnchorEngine();
+
+	const char* getName() const { return "anchors"; }
+	EngineCost EstimateCost(const AlignmentStats& stats) const;
+	void Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts);
+};
+
+/**********************************/
+/*   Параметры выбора алгоритма   */
+/**********************************/
+class EngineOptions
+{
+public:
+	EngineOptions() : memory_budget(1024ull << 20), verbose(false) {};
+	unsigned long long memory_budget; // В байтах
+	bool verbose;
+};
+
+/*****************************************/
+/*   Выбор алгоритма в пределах памяти   */
+/*****************************************/
+// Точный lcs, если он укладывается в бюджет, иначе самый быстрый из укладывающихся.
+// Алгоритмы-кандидаты создаются один раз и сохраняют своё состояние между сопоставлениями.
+class AutoEngine : public AlignmentEngine
+{
+	EngineOptions _options; // Передаются и выбранному алгоритму
+	std::vector<AlignmentEnginePtr> _engines;
+
+public:
+	explicit AutoEngine(const EngineOptions& options);
+
+	const char* getName() const { return "auto"; }
+	EngineCost EstimateCost(const AlignmentStats& stats) const;
+	void Align(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& desync_points, SegmentShifts& shifts);
+
+	AlignmentEngine* Select(const AlignmentStats& stats) const;
+};
+
+
+AlignmentEnginePtr CreateEngine(const std::string& name, const EngineOptions& options = EngineOptions());
+void BenchmarkEngines(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params);
@@ -0,0 +1,241 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <fstream>
+
+#include "exception.h"
+#include "filter.h"
+
+
+// Встроенный набор, построенный filtergen при сборке
+#include "filter_tables.h"
+
+
+/***********************************/
+/*   Чтение таблиц из файла (LE)   */
+/***********************************/
+inline unsigned int ReadUInt(std::istream& in)
+{
+	unsigned char bytes[4] = {0, 0, 0, 0};
+	in.read(reinterpret_cast<char*>(bytes), 4);
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<unsigned int>(bytes[3]) << 24);
+}
+
+void KeywordFilter::Load(const std::string& filename)
+{
+	std::ifstream fin(filename.c_str(), std::ios_base::binary);
+	if (!fin.is_open())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Сan't open file for reading"))
+			<< error_message(L"Ошибка открытия файла для чтения")
+		);
+	}
+
+	char magic[4];
+	fin.read(magic, 4);
+	const unsigned int version = ReadUInt(fin);
+	const unsigned int classes = ReadUInt(fin);
+	const unsigned int states = ReadUInt(fin);
+	if ( !fin.good() || !std::equal(magic, magic + 4, KEYWORD_TABLE_MAGIC) || version != KEYWORD_TABLE_VERSION
+		|| classes < 1 || classes > 0x100 || states < 1 || states > (1u << 24) / classes )
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Wrong keyword table header"))
+			<< error_message(L"Неправильный заголовок таблицы ключевых слов")
+		);
+	}
+
+	_ascii_class.resize(ASCII_SIZE);
+	_cyrillic_class.resize(CYRILLIC_SIZE);
+	_next.resize(states * classes);
+	_output.resize(states);
+	fin.read(reinterpret_cast<char*>(&_ascii_class[0]), ASCII_SIZE);
+	fin.read(reinterpret_cast<char*>(&_cyrillic_class[0]), CYRILLIC_SIZE);
+	for (std::vector<unsigned int>::iterator it = _next.begin(); it != _next.end(); ++it)
+	{
+		*it = ReadUInt(fin);
+	}
+	fin.read(reinterpret_cast<char*>(&_output[0]), states);
+
+	// Все индексы должны оставаться внутри таблиц
+	bool valid = fin.good();
+	for (size_t i = 0; valid && i < _ascii_class.size(); ++i) valid = _ascii_class[i] < classes;
+	for (size_t i = 0; valid && i < _cyrillic_class.size(); ++i) valid = _cyrillic_class[i] < classes;
+	for (size_t i = 0; valid && i < _next.size(); ++i) valid = _next[i] < states;
+	if (!valid)
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Broken keyword table"))
+			<< error_message(L"Повреждённая таблица ключевых слов")
+		);
+	}
+
+	Attach(classes);
+}
+
+bool KeywordFilter::Contains(const std::wstring& text, unsigned char kinds) const
+{
+	return Contains(text.data(), text.data() + text.size(), kinds);
+}
+
+bool KeywordFilter::Contains(const wchar_t* begin, const wchar_t* end, unsigned char kinds) const
+{
+	unsigned int state = 0;
+
+	for (const wchar_t* it = begin; it != end; ++it)
+	{
+		unsigned int cls = Classify(*it);
+
+		// В начальном состоянии пропускаем символы, с которых не начинается ни одно слово
+		if (state == 0)
+		{
+			while (_tables.next[cls] == 0)
+			{
+				if (++it == end) return false;
+				cls = Classify(*it);
+			}
+		}
+
+		state = _tables.next[state * _tables.classes + cls];
+		if (_tables.output[state] & kinds) return true;
+	}
+
+	return false;
+}
+
+/*****************************************************/
+/*   Разделители строк (как у ^ и $ в Boost.Regex)   */
+/*****************************************************/
+inline bool IsLineSeparator(wchar_t c)
+{
+	return c == L'\n' || c == L'\r' || c == L'\f' || c == 0x85 || c == 0x2028 || c == 0x2029;
+}
+
+inline bool IsLineStart(const std::wstring& text, size_t pos)
+{
+	if (pos == 0) return true;
+	return IsLineSeparator(text[pos - 1]) && !(text[pos - 1] == L'\r' && pos < text.size() && text[pos] == L'\n');
+}
+
+inline bool IsLineEnd(const std::wstring& text, size_t pos)
+{
+	if ( pos == text.size() ) return true;
+	return IsLineSeparator(text[pos]) && !(text[pos] == L'\n' && pos > 0 && text[pos - 1] == L'\r');
+}
+
+/******************************************/
+/*   Строка вида [...] (^\[(\s|\S)+\]$)   */
+/******************************************/
+inline bool IsBracketed(const std::wstring& text)
+{
+	// Самая ранняя строка, начинающаяся с '[', и самая поздняя, заканчивающаяся на ']'
+	size_t first = text.find(L'[');
+	while ( first != std::wstring::npos && !IsLineStart(text, first) )
+	{
+		first = text.find(L'[', first + 1);
+	}
+	if (first == std::wstring::npos) return false;
+
+	for (size_t last = text.size(); last >= first + 3; --last)
+	{
+		if ( text[last - 1] == L']' && IsLineEnd(text, last) ) return true;
+	}
+
+	return false;
+}
+
+/****************************/
+/*   Тег позиционирования   */
+/****************************/
+inline bool HasPositionTag(const wchar_t* begin, const wchar_t* end)
+{
+	for (const wchar_t* it = std::find(begin, end, L'\\'); it != end; it = std::find(it + 1, end, L'\\'))
+	{
+		if ( end - it > 3 && FoldCase(it[1]) == L'p' && FoldCase(it[2]) == L'o' && FoldCase(it[3]) == L's' ) return true;
+	}
+
+	return false;
+}
+
+// Предел кэша полей; при уникальных именах у каждого события поиск по кэшу бесполезен
+static const size_t MAX_FIELDS = 64;
+
+static const KeywordFilter DEFAULT_KEYWORDS(DEFAULT_TABLES);
+
+const KeywordFilter& DefaultKeywords()
+{
+	return DEFAULT_KEYWORDS;
+}
+
+bool IsCommentaryText(const KeywordFilter& keywords, const std::wstring& text, bool skip_lyrics)
+{
+	return keywords.Contains(text, KEYWORD_COMMENTARY | (skip_lyrics ? KEYWORD_LYRICS : 0))
+		|| HasPositionTag(text.data(), text.data() + text.size()) || IsBracketed(text);
+}
+
+bool PhraseFilter::IsCommentary(const std::wstring& text, bool skip_lyrics)
+{
+	return IsCommentaryText(*_keywords, text, skip_lyrics);
+}
+
+/********************************************/
+/*   Значение поля Style или Name из кэша   */
+/********************************************/
+const AssEventFilter::Field& AssEventFilter::Intern(const std::wstring& text, size_t begin, size_t end)
+{
+	// Подряд обычно идут события одного стиля
+	const size_t length = end - begin;
+	if ( _last < _fields.size() && _fields[_last].value.size() == length && text.compare(begin, length, _fields[_last].value) == 0 ) return _fields[_last];
+
+	for (_last = 0; _last < _fields.size(); ++_last)
+	{
+		if ( _fields[_last].value.size() == length && text.compare(begin, length, _fields[_last].value) == 0 ) return _fields[_last];
+	}
+
+	// Запятая после поля нужна для слов вида "op,"
+	Field& field = _fields.size() < MAX_FIELDS ? *_fields.insert(_fields.end(), Field()) : _uncached;
+	field.value.assign(text, begin, length);
+	std::wstring checked(field.value + L',');
+	field.commentary = _keywords->Contains(checked, KEYWORD_COMMENTARY) || HasPositionTag(checked.data(), checked.data() + checked.size());
+	field.lyrics = _keywords->Contains(checked, KEYWORD_LYRICS);
+
+	return field;
+}
+
+bool AssEventFilter::IsCommentary(const std::wstring& text, bool skip_lyrics)
+{
+	// Ключевые слова не содержат запятых (кроме последнего символа), поэтому поля можно проверять по отдельности
+	const size_t style_end = text.find(L',');
+	const size_t name_end = style_end == std::wstring::npos ? style_end : text.find(L',', style_end + 1);
+	if (name_end == std::wstring::npos) return IsCommentaryText(*_keywords, text, skip_lyrics);
+
+	const Field& style = Intern(text, 0, style_end);
+	if ( style.commentary || (skip_lyrics && style.lyrics) ) return true;
+
+	const Field& name = Intern(text, style_end + 1, name_end);
+	if ( name.commentary || (skip_lyrics && name.lyrics) ) return true;
+
+	// Остальные поля и текст; правило [...] затрагивает строку целиком
+	const wchar_t* rest = text.data() + name_end + 1;
+	const wchar_t* end = text.data() + text.size();
+	return _keywords->Contains(rest, end, KEYWORD_COMMENTARY | (skip_lyrics ? KEYWORD_LYRICS : 0))
+		|| HasPositionTag(rest, end) || IsBracketed(text);
+}
@@ -0,0 +1,168 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+// Виды ключевых слов фильтра (битовая маска)
+enum KeywordKind
+{
+	KEYWORD_COMMENTARY = 1, // Комментарии авторов перевода
+	KEYWORD_LYRICS     = 2  // Тексты песен
+};
+
+// Символы, которые могут входить в ключевые слова после приведения к нижнему регистру
+const unsigned int ASCII_SIZE = 0x80;
+const unsigned int CYRILLIC_FIRST = 0x430, CYRILLIC_SIZE = 0x30;
+
+// Заголовок файла таблиц
+const char KEYWORD_TABLE_MAGIC[] = "RSKW";
+const unsigned int KEYWORD_TABLE_VERSION = 1;
+
+/*********************************************/
+/*   Приведение символа к нижнему регистру   */
+/*********************************************/
+inline wchar_t FoldCase(wchar_t c)
+{
+	if (c >= L'A' && c <= L'Z') return c + (L'a' - L'A');
+	if (c >= 0x410 && c <= 0x42F) return c + 0x20; // А-Я
+	if (c >= 0x400 && c <= 0x40F) return c + 0x50; // Ѐ-Џ
+	if (c == 0x130) return L'i'; // İ
+	if (c == 0x212A) return L'k'; // Знак кельвина
+	return c;
+}
+
+/**************************************/
+/*   Таблицы автомата ключевых слов   */
+/**************************************/
+struct KeywordTables
+{
+	unsigned int classes, states;
+	const unsigned char* ascii_class;    // Класс символа, ASCII_SIZE элементов
+	const unsigned char* cyrillic_class; // Класс символа, CYRILLIC_SIZE элементов с CYRILLIC_FIRST
+	const unsigned int* next;            // Переходы: состояние * classes + класс
+	const unsigned char* output;         // Виды слов, заканчивающихся в состоянии
+};
+
+/***************************************************************/
+/*   Поиск набора ключевых слов без учёта регистра (автомат)   */
+/***************************************************************/
+class KeywordFilter
+{
+public:
+	// Пустой набор
+	KeywordFilter();
+	// Таблицы, построенные заранее (filter_tables.h); данные не копируются
+	explicit KeywordFilter(const KeywordTables& tables);
+
+	// Построение автомата (keywords.cpp, используется filtergen)
+	void AddKeyword(const std::wstring& keyword, unsigned char kind);
+	void Compile();
+	void Save(const std::string& filename) const;
+
+	// Загрузка таблиц, построенных filtergen
+	void Load(const std::string& filename);
+
+	const KeywordTables& getTables() const { return _tables; }
+
+	// Есть ли в тексте слово одного из видов kinds
+	bool Contains(const wchar_t* begin, const wchar_t* end, unsigned char kinds) const;
+	bool Contains(const std::wstring& text, unsigned char kinds) const;
+
+private:
+	KeywordFilter(const KeywordFilter&);
+	KeywordFilter& operator=(const KeywordFilter&);
+
+	// Перенаправление _tables на собственные массивы
+	void Attach(unsigned int classes);
+	unsigned int Classify(wchar_t c) const;
+
+	KeywordTables _tables;
+	std::vector<std::wstring> _keywords;
+	std::vector<unsigned char> _kinds;
+	std::vector<unsigned char> _ascii_class, _cyrillic_class, _output;
+	std::vector<unsigned int> _next;
+};
+
+inline KeywordFilter::KeywordFilter()
+{
+	_ascii_class.assign(ASCII_SIZE, 0);
+	_cyrillic_class.assign(CYRILLIC_SIZE, 0);
+	_next.assign(1, 0);
+	_output.assign(1, 0);
+	Attach(1);
+}
+
+inline KeywordFilter::KeywordFilter(const KeywordTables& tables) : _tables(tables)
+{
+}
+
+inline void KeywordFilter::Attach(unsigned int classes)
+{
+	_tables.classes = classes;
+	_tables.states = static_cast<unsigned int>(_output.size());
+	_tables.ascii_class = &_ascii_class[0];
+	_tables.cyrillic_class = &_cyrillic_class[0];
+	_tables.next = &_next[0];
+	_tables.output = &_output[0];
+}
+
+inline unsigned int KeywordFilter::Classify(wchar_t c) const
+{
+	c = FoldCase(c);
+	if (c >= 0 && static_cast<unsigned int>(c) < ASCII_SIZE) return _tables.ascii_class[c];
+	if (static_cast<unsigned int>(c) >= CYRILLIC_FIRST && static_cast<unsigned int>(c) < CYRILLIC_FIRST + CYRILLIC_SIZE) return _tables.cyrillic_class[c - CYRILLIC_FIRST];
+	return 0;
+}
+
+// Встроенный набор слов (keywords.cpp)
+void AddDefaultKeywords(KeywordFilter& filter);
+// Встроенный набор, построенный при сборке
+const KeywordFilter& DefaultKeywords();
+
+bool IsCommentaryText(const KeywordFilter& keywords, const std::wstring& text, bool skip_lyrics);
+
+/*******************/
+/*   Фильтр фраз   */
+/*******************/
+class PhraseFilter
+{
+public:
+	explicit PhraseFilter(const KeywordFilter& keywords = DefaultKeywords()) : _keywords(&keywords) {};
+	virtual ~PhraseFilter() {};
+
+	virtual bool IsCommentary(const std::wstring& text, bool skip_lyrics);
+	// Новый фильтр с тем же набором слов, для другого потока
+	virtual PhraseFilter* Clone() const { return new PhraseFilter(*_keywords); }
+
+protected:
+	const KeywordFilter* _keywords;
+};
+
+/*****************************************************/
+/*   Фильтр событий ASS с кэшем по стилям и именам   */
+/*****************************************************/
+class AssEventFilter : public PhraseFilter
+{
+public:
+	explicit AssEventFilter(const KeywordFilter& keywords = DefaultKeywords()) : PhraseFilter(keywords), _last(0) {};
+
+	// text - поля события "Style,Name,MarginL,MarginR,MarginV,Effect,Text"
+	virtual bool IsCommentary(const std::wstring& text, bool skip_lyrics);
+	virtual PhraseFilter* Clone() const { return new AssEventFilter(*_keywords); }
+
+	// Число различных значений полей Style и Name
+	size_t getFieldCount() const { return _fields.size(); }
+
+private:
+	struct Field
+	{
+		std::wstring value;
+		bool commentary, lyrics;
+	};
+
+	const Field& Intern(const std::wstring& text, size_t begin, size_t end);
+
+	std::vector<Field> _fields;
+	Field _uncached; // Поле, не поместившееся в кэш
+	size_t _last;
+};
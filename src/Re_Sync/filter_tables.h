@@ -0,0 +1,643 @@
+// Generated by filtergen, do not edit
+#pragma once
+
+static const unsigned char DEFAULT_ASCII_CLASS[128] = {
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	40,0,0,0,0,0,0,0,0,0,0,0,42,43,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,41,
+	0,3,0,15,11,7,0,12,39,9,0,16,6,10,4,8,
+	14,17,2,5,1,0,0,0,0,13,0,0,0,0,0,0
+};
+
+static const unsigned char DEFAULT_CYRILLIC_CLASS[48] = {
+	25,0,21,30,23,19,0,0,28,26,33,32,27,29,22,18,
+	20,31,24,36,35,0,37,0,0,0,0,0,0,34,0,38,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
+static const unsigned int DEFAULT_NEXT[9592] = {
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,2,0,
+	64,47,173,36,198,15,0,0,0,23,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,3,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,4,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,190,64,5,173,36,65,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,48,0,0,
+	64,47,6,36,198,170,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,7,64,47,173,36,
+	174,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,8,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,2,0,64,47,173,9,10,12,0,0,0,23,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	37,47,173,36,198,177,0,204,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,11,0,64,47,173,36,
+	198,177,0,0,0,0,199,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,160,0,0,178,47,173,36,13,177,16,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	14,47,173,36,198,177,0,0,0,0,199,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,190,64,47,173,36,
+	65,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,160,0,0,178,47,173,36,198,177,16,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,17,198,20,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,19,0,
+	37,47,173,36,198,177,0,18,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	205,206,207,208,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,21,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,190,
+	64,179,173,36,65,177,0,0,22,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,24,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,25,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	37,26,173,36,198,177,0,204,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,48,0,0,64,47,173,27,
+	198,170,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,28,0,0,37,47,173,36,198,177,0,204,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,29,2,0,64,47,173,36,198,15,0,0,0,23,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,2,0,
+	64,47,173,30,198,33,0,0,0,23,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,32,0,37,47,173,36,
+	198,177,0,31,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,205,206,207,208,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,160,0,0,
+	34,47,173,36,198,177,16,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,190,64,179,173,36,
+	65,177,0,0,35,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,37,47,173,36,198,177,0,204,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,190,
+	64,47,173,36,65,177,0,214,0,0,0,38,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,193,0,64,47,173,36,
+	39,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,165,40,
+	0,0,183,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,41,198,44,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,43,0,
+	37,47,173,36,198,177,0,42,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	205,206,207,208,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,45,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,190,
+	64,179,173,36,65,177,0,0,46,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,48,0,0,64,47,173,36,198,170,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,2,0,64,47,173,36,198,15,0,0,0,49,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,50,36,198,177,0,0,0,0,24,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,51,
+	174,54,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,53,0,37,47,173,36,198,177,0,52,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,205,206,207,208,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,55,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,190,64,179,173,36,65,177,0,0,
+	56,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,58,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,59,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,60,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,61,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,199,163,62,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,58,64,47,173,63,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,37,47,173,36,198,177,0,204,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,190,64,47,173,36,65,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,66,0,0,
+	64,47,173,36,198,177,0,0,0,0,199,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,2,0,64,47,173,67,
+	198,15,0,0,0,23,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,37,47,173,36,198,177,0,204,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,69,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,193,0,
+	64,47,173,36,164,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,71,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,72,0,117,0,77,0,0,0,
+	0,97,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,73,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,74,117,129,77,0,0,0,0,97,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,75,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,76,77,0,0,0,
+	0,0,0,84,0,106,101,118,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,78,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,79,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,92,96,127,0,117,0,77,0,0,80,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,81,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,82,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,83,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,85,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,86,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,87,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,92,96,127,0,117,0,77,0,0,80,
+	0,0,0,84,88,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,89,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,90,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,91,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,71,127,0,117,0,77,0,0,0,0,0,0,93,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,94,
+	127,0,117,0,85,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	95,0,0,0,0,97,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,78,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,97,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,98,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,99,0,
+	77,149,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,100,77,0,0,155,
+	0,0,0,84,0,106,101,118,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,109,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,102,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,103,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,104,0,77,149,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,105,77,0,0,155,0,0,0,84,
+	0,106,101,118,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,109,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,107,0,
+	77,149,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,108,77,0,0,155,
+	0,0,0,84,0,106,101,118,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,109,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	110,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,128,127,0,111,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,112,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,118,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,113,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,114,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,115,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,116,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,97,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,118,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,119,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,120,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,118,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,128,127,0,117,0,77,0,0,121,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,122,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,123,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,124,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,125,0,0,84,
+	0,98,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,126,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,97,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,128,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,129,77,0,0,0,0,97,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,130,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,131,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,107,0,132,149,0,0,
+	0,0,0,84,0,106,101,0,0,146,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,133,0,77,78,0,0,135,0,0,84,
+	0,106,101,0,143,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	134,0,117,0,77,0,0,0,0,0,0,84,0,106,101,118,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,128,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,136,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,128,127,0,137,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,138,117,0,77,0,0,0,0,0,0,84,0,106,101,118,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,139,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,140,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,141,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,142,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,97,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,144,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,128,127,0,117,0,77,145,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,147,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,148,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	150,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,128,127,0,117,0,
+	77,151,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,152,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,153,101,118,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,154,
+	127,0,107,0,77,149,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,97,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,156,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,157,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,158,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	159,0,0,0,0,0,0,84,0,98,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,78,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,2,0,64,47,161,36,198,15,0,0,0,23,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,162,174,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,37,47,173,36,
+	198,177,0,204,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,193,0,64,47,173,36,164,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,165,0,0,0,183,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,166,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,167,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,168,47,173,36,198,177,0,204,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,169,0,190,64,47,173,36,65,177,0,214,0,0,0,38,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,2,0,
+	64,47,173,36,198,15,0,0,0,23,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,178,47,173,36,
+	198,177,0,0,171,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,172,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,190,64,47,173,36,65,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,174,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,175,0,199,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,176,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,199,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	178,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,190,64,179,173,36,
+	65,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,48,0,0,64,47,173,180,198,170,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,181,0,37,47,173,36,198,177,0,204,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,182,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,2,0,64,47,173,36,
+	198,15,0,0,0,23,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,209,198,177,0,0,
+	0,184,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,200,201,202,203,
+	0,1,185,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,186,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,178,47,173,36,
+	198,177,0,0,187,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,188,0,0,0,0,
+	0,189,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,2,0,
+	64,47,173,36,198,15,0,0,0,23,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,191,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,192,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,37,47,173,36,198,177,0,204,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,194,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,37,47,173,36,
+	198,177,0,195,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,196,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,205,206,207,208,
+	0,197,0,0,178,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,2,0,
+	64,47,173,36,198,15,0,0,0,23,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,199,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,209,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,200,201,202,203,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,205,206,207,208,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,177,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,64,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,0,64,47,173,36,198,177,0,0,0,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	210,47,173,36,198,177,0,204,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,190,64,47,173,36,
+	65,211,0,214,0,0,0,38,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,212,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,190,64,179,173,36,65,177,0,0,213,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0,0,1,0,0,64,47,173,36,
+	198,215,0,0,0,0,0,163,57,68,70,96,127,0,117,0,
+	77,0,0,0,0,0,0,84,0,106,101,0,0,0,0,0,
+	0,0,0,0,0,1,0,0,216,47,173,36,198,177,0,0,
+	0,0,0,163,57,68,70,96,127,0,117,0,77,0,0,0,
+	0,0,0,84,0,106,101,0,0,0,0,0,0,0,0,0,
+	0,1,0,190,64,179,173,36,65,177,0,0,217,0,0,163,
+	57,68,70,96,127,0,117,0,77,0,0,0,0,0,0,84,
+	0,106,101,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	64,47,173,36,198,177,0,0,0,0,0,163,57,68,70,96,
+	127,0,117,0,77,0,0,0,0,0,0,84,0,106,101,0,
+	0,0,0,0,0,0,0,0
+};
+
+static const unsigned char DEFAULT_OUTPUT[218] = {
+	0,0,0,0,0,0,0,0,0,1,0,1,0,0,1,0,
+	0,0,1,1,0,0,1,0,0,0,0,0,0,0,0,1,
+	1,0,0,1,0,0,0,0,0,0,1,1,0,0,1,0,
+	0,0,0,0,1,1,0,0,1,0,0,0,0,0,0,1,
+	0,0,0,1,0,1,0,0,0,0,0,0,1,0,0,0,
+	0,0,0,1,0,0,0,0,0,0,0,1,0,0,0,1,
+	0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,
+	0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,
+	0,0,0,0,0,0,1,0,0,0,0,0,0,0,1,0,
+	0,1,0,0,1,0,0,0,0,0,1,0,0,0,0,1,
+	0,0,1,0,0,0,0,0,0,1,0,0,1,0,0,0,
+	1,0,0,0,0,0,1,0,0,0,0,0,0,1,0,0,
+	1,0,0,0,0,1,0,0,2,2,2,2,0,2,2,2,
+	2,0,0,0,0,2,0,0,0,2
+};
+
+static const KeywordTables DEFAULT_TABLES = {
+	44, 218, DEFAULT_ASCII_CLASS, DEFAULT_CYRILLIC_CLASS, DEFAULT_NEXT, DEFAULT_OUTPUT
+};
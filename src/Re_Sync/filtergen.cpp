@@ -0,0 +1,167 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Генератор таблиц фильтра ключевых слов.
+ *
+ * filtergen --header <файл.h>
+ *     встроенный набор слов в виде исходного кода (filter_tables.h, при сборке)
+ * filtergen <список слов> <файл таблицы>
+ *     встроенный набор вместе со словами из списка, для параметра --keywords
+ *
+ * Список слов: по слову на строку, строки с # пропускаются.
+ * Заголовки [commentary] и [lyrics] задают вид следующих слов (по умолчанию commentary).
+ * Пробелы внутри и по краям строки входят в слово.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <locale>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include "exception.h"
+#include "filter.h"
+
+#ifdef __GNUC__
+# include "unix/io.h"
+#else
+# include "windows/io.h"
+#endif
+
+#ifdef _MSC_VER
+# define CONSOLE_LOCALE ".OCP"
+#else
+# define CONSOLE_LOCALE ""
+#endif
+
+
+/***************************************/
+/*   Чтение пользовательского списка   */
+/***************************************/
+void AddKeywordList(KeywordFilter& filter, const std::string& filename)
+{
+	std::wstring content;
+	io::ReadFile(filename, content);
+
+	unsigned char kind = KEYWORD_COMMENTARY;
+	std::wistringstream input(content);
+	std::wstring line;
+	while ( std::getline(input, line) )
+	{
+		if ( !line.empty() && line[line.size() - 1] == L'\r' ) line.erase(line.size() - 1);
+		if ( line.empty() || line[0] == L'#' ) continue;
+
+		if (line == L"[commentary]") kind = KEYWORD_COMMENTARY;
+		else if (line == L"[lyrics]") kind = KEYWORD_LYRICS;
+		else filter.AddKeyword(line, kind);
+	}
+}
+
+/******************************/
+/*   Массив в исходном коде   */
+/******************************/
+template<typename T>
+void WriteArray(std::ostream& out, const char* type, const char* name, const T* data, unsigned int size)
+{
+	out << "static const " << type << " " << name << "[" << size << "] = {";
+	for (unsigned int i = 0; i < size; ++i)
+	{
+		if (i % 16 == 0) out << "\n\t";
+		out << static_cast<unsigned int>(data[i]) << (i + 1 < size ? "," : "");
+	}
+	out << "\n};\n\n";
+}
+
+void WriteHeader(const KeywordFilter& filter, const std::string& filename)
+{
+	std::ofstream fout(filename.c_str(), std::ios_base::binary);
+	if (!fout.is_open())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Сan't open file for writing"))
+			<< error_message(L"Ошибка открытия файла для записи")
+		);
+	}
+
+	const KeywordTables& tables = filter.getTables();
+	fout << "// Generated by filtergen, do not edit\n#pragma once\n\n";
+	WriteArray(fout, "unsigned char", "DEFAULT_ASCII_CLASS", tables.ascii_class, ASCII_SIZE);
+	WriteArray(fout, "unsigned char", "DEFAULT_CYRILLIC_CLASS", tables.cyrillic_class, CYRILLIC_SIZE);
+	WriteArray(fout, "unsigned int", "DEFAULT_NEXT", tables.next, tables.states * tables.classes);
+	WriteArray(fout, "unsigned char", "DEFAULT_OUTPUT", tables.output, tables.states);
+	fout << "static const KeywordTables DEFAULT_TABLES = {\n\t" << tables.classes << ", " << tables.states
+		<< ", DEFAULT_ASCII_CLASS, DEFAULT_CYRILLIC_CLASS, DEFAULT_NEXT, DEFAULT_OUTPUT\n};\n";
+
+	if (!fout.good())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Can't write header"))
+			<< error_message(L"Ошибка записи заголовка")
+		);
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	std::locale::global( std::locale(CONSOLE_LOCALE) );
+
+	if (argc != 3)
+	{
+		std::wcout << L"Использование:" << std::endl
+			<< L"  " << argv[0] << L" --header <файл.h>" << std::endl
+			<< L"  " << argv[0] << L" <список слов> <файл таблицы>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		KeywordFilter filter;
+		AddDefaultKeywords(filter);
+
+		if (strcmp(argv[1], "--header") == 0)
+		{
+			filter.Compile();
+			WriteHeader(filter, argv[2]);
+		}
+		else
+		{
+			AddKeywordList(filter, argv[1]);
+			filter.Compile();
+			filter.Save(argv[2]);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::wcerr << L"Ошибка: ";
+		if ( std::wstring const* info = boost::get_error_info<error_message>(e) )
+		{
+			std::wcerr << (*info) << std::endl;
+		}
+		else
+		{
+			std::wcerr << e.what() << std::endl;
+		}
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+
+#include "hash.h"
+
+
+static const unsigned long long PRIME64_1 = 0x9E3779B185EBCA87ull;
+static const unsigned long long PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static const unsigned long long PRIME64_3 = 0x165667B19E3779F9ull;
+static const unsigned long long PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static const unsigned long long PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static inline unsigned long long Rotl64(unsigned long long x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// Чтение без требований к выравниванию, порядок байт - little-endian
+static inline unsigned long long Read64(const unsigned char* p)
+{
+	unsigned long long value = 0;
+	for (int i = 7; i >= 0; --i) value = (value << 8) | p[i];
+	return value;
+}
+
+static inline unsigned long long Read32(const unsigned char* p)
+{
+	return static_cast<unsigned long long>(p[0]) | (static_cast<unsigned long long>(p[1]) << 8)
+		| (static_cast<unsigned long long>(p[2]) << 16) | (static_cast<unsigned long long>(p[3]) << 24);
+}
+
+static inline unsigned long long Round(unsigned long long acc, unsigned long long input)
+{
+	acc += input * PRIME64_2;
+	acc = Rotl64(acc, 31);
+	return acc * PRIME64_1;
+}
+
+static inline unsigned long long MergeRound(unsigned long long acc, unsigned long long value)
+{
+	acc ^= Round(0, value);
+	return acc * PRIME64_1 + PRIME64_4;
+}
+
+// Остаток меньше блока и перемешивание
+static unsigned long long Finalize(unsigned long long hash, const unsigned char* p, const unsigned char* end)
+{
+	for (; p + 8 <= end; p += 8)
+	{
+		hash ^= Round(0, Read64(p));
+		hash = Rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+	}
+	if (p + 4 <= end)
+	{
+		hash ^= Read32(p) * PRIME64_1;
+		hash = Rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+		p += 4;
+	}
+	for (; p < end; ++p)
+	{
+		hash ^= (*p) * PRIME64_5;
+		hash = Rotl64(hash, 11) * PRIME64_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+static inline unsigned long long MergeAccumulators(unsigned long long v1, unsigned long long v2, unsigned long long v3, unsigned long long v4)
+{
+	unsigned long long hash = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+	hash = MergeRound(hash, v1);
+	hash = MergeRound(hash, v2);
+	hash = MergeRound(hash, v3);
+	hash = MergeRound(hash, v4);
+	return hash;
+}
+
+unsigned long long XXHash64(const void* data, size_t size, unsigned long long seed)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const unsigned char* const end = p + size;
+	unsigned long long hash;
+
+	if (size >= 32u)
+	{
+		const unsigned char* const limit = end - 32;
+		unsigned long long v1 = seed + PRIME64_1 + PRIME64_2;
+		unsigned long long v2 = seed + PRIME64_2;
+		unsigned long long v3 = seed;
+		unsigned long long v4 = seed - PRIME64_1;
+		do
+		{
+			v1 = Round(v1, Read64(p));
+			v2 = Round(v2, Read64(p + 8));
+			v3 = Round(v3, Read64(p + 16));
+			v4 = Round(v4, Read64(p + 24));
+			p += 32;
+		}
+		while (p <= limit);
+
+		hash = MergeAccumulators(v1, v2, v3, v4);
+	}
+	else
+	{
+		hash = seed + PRIME64_5;
+	}
+
+	hash += static_cast<unsigned long long>(size);
+	return Finalize(hash, p, end);
+}
+
+/*****************/
+/*   По частям   */
+/*****************/
+XXHash64State::XXHash64State(unsigned long long seed)
+	: _seed(seed), _total(0),
+	_v1(seed + PRIME64_1 + PRIME64_2), _v2(seed + PRIME64_2), _v3(seed), _v4(seed - PRIME64_1),
+	_buffered(0)
+{
+}
+
+void XXHash64State::Update(const void* data, size_t size)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const unsigned char* const end = p + size;
+	_total += size;
+
+	// Дополняем неполный блок с прошлого раза
+	if (_buffered > 0)
+	{
+		const size_t fill = std::min(size, sizeof(_buffer) - _buffered);
+		memcpy(_buffer + _buffered, p, fill);
+		_buffered += fill;
+		p += fill;
+		if (_buffered < sizeof(_buffer)) return;
+
+		_v1 = Round(_v1, Read64(_buffer));
+		_v2 = Round(_v2, Read64(_buffer + 8));
+		_v3 = Round(_v3, Read64(_buffer + 16));
+		_v4 = Round(_v4, Read64(_buffer + 24));
+		_buffered = 0;
+	}
+
+	for (; end - p >= 32; p += 32)
+	{
+		_v1 = Round(_v1, Read64(p));
+		_v2 = Round(_v2, Read64(p + 8));
+		_v3 = Round(_v3, Read64(p + 16));
+		_v4 = Round(_v4, Read64(p + 24));
+	}
+
+	_buffered = end - p;
+	if (_buffered > 0) memcpy(_buffer, p, _buffered);
+}
+
+unsigned long long XXHash64State::Digest() const
+{
+	unsigned long long hash = _total >= 32u ? MergeAccumulators(_v1, _v2, _v3, _v4) : _seed + PRIME64_5;
+	hash += _total;
+	return Finalize(hash, _buffer, _buffer + _buffered);
+}
@@ -0,0 +1,23 @@
+﻿#pragma once
+
+#include <cstddef>
+
+
+// 64-битный xxHash (XXH64)
+unsigned long long XXHash64(const void* data, size_t size, unsigned long long seed = 0);
+
+// XXH64 по частям, например по мере чтения файла: тот же результат, что XXHash64 от всех частей подряд
+class XXHash64State
+{
+public:
+	explicit XXHash64State(unsigned long long seed = 0);
+
+	void Update(const void* data, size_t size);
+	unsigned long long Digest() const;
+
+private:
+	unsigned long long _seed, _total;
+	unsigned long long _v1, _v2, _v3, _v4;
+	unsigned char _buffer[32]; // Неполный блок с прошлой части
+	size_t _buffered;
+};
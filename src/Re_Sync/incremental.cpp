@@ -0,0 +1,287 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cstring>
+#include <fstream>
+
+#include <boost/cstdint.hpp>
+
+#include "exception.h"
+#include "incremental.h"
+
+
+static const char STATE_MAGIC[8] = {'R', 'E', 'S', 'Y', 'N', 'C', 'S', 'T'};
+static const boost::uint32_t STATE_VERSION = 1;
+
+static void WriteValue(std::ofstream& fout, boost::uint32_t value)
+{
+	fout.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static bool ReadValue(std::ifstream& fin, boost::uint32_t& value)
+{
+	return static_cast<bool>( fin.read(reinterpret_cast<char*>(&value), sizeof(value)) );
+}
+
+// Сдвиги начинаются с участка до первой точки, если он не пуст
+static size_t LeadingSegments(const DesyncGroups& desync_points)
+{
+	return !desync_points.empty() && desync_points[0].desync[0] > 0 ? 1u : 0u;
+}
+
+/*******************************************/
+/*   Сохранённое состояние сопоставления   */
+/*******************************************/
+AlignmentState::AlignmentState(unsigned long long key, const PhraseGroups& desync, const DesyncGroups& desync_points, const SegmentShifts& shifts)
+	: key(key), desync_points(desync_points), shifts(shifts)
+{
+	groups.reserve(desync.size());
+	for (PhraseGroups::const_iterator it = desync.begin(); it != desync.end(); ++it)
+	{
+		groups.push_back( Timing(it->getBegin(), it->getEnd(), it->getOffset()) );
+	}
+}
+
+void AlignmentState::Save(const std::string& filename) const
+{
+	std::ofstream fout(filename.c_str(), std::ios_base::binary);
+	if (!fout.is_open())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Can't open file for writing"))
+			<< error_message(L"Ошибка открытия файла для записи")
+		);
+	}
+
+	fout.write(STATE_MAGIC, sizeof(STATE_MAGIC));
+	WriteValue(fout, STATE_VERSION);
+	WriteValue(fout, static_cast<boost::uint32_t>(key));
+	WriteValue(fout, static_cast<boost::uint32_t>(key >> 32));
+	WriteValue(fout, static_cast<boost::uint32_t>(groups.size()));
+	WriteValue(fout, static_cast<boost::uint32_t>(desync_points.size()));
+	WriteValue(fout, static_cast<boost::uint32_t>(shifts.size()));
+
+	for (std::vector<Timing>::const_iterator it = groups.begin(); it != groups.end(); ++it)
+	{
+		WriteValue(fout, it->begin);
+		WriteValue(fout, it->end);
+		WriteValue(fout, it->offset);
+	}
+	for (DesyncGroups::const_iterator it = desync_points.begin(); it != desync_points.end(); ++it)
+	{
+		WriteValue(fout, static_cast<boost::uint32_t>(it->sync.size()));
+		WriteValue(fout, static_cast<boost::uint32_t>(it->desync.size()));
+		for (DesyncPositions::const_iterator pos = it->sync.begin(); pos != it->sync.end(); ++pos) WriteValue(fout, static_cast<boost::uint32_t>(*pos));
+		for (DesyncPositions::const_iterator pos = it->desync.begin(); pos != it->desync.end(); ++pos) WriteValue(fout, static_cast<boost::uint32_t>(*pos));
+	}
+	for (SegmentShifts::const_iterator it = shifts.begin(); it != shifts.end(); ++it)
+	{
+		WriteValue(fout, static_cast<boost::uint32_t>(it->begin));
+		WriteValue(fout, static_cast<boost::uint32_t>(it->end));
+		WriteValue(fout, static_cast<boost::uint32_t>(it->shift));
+	}
+
+	fout.close();
+	if (!fout)
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("State write error"))
+			<< error_message(L"Ошибка записи состояния")
+		);
+	}
+}
+
+bool AlignmentState::Load(const std::string& filename, unsigned long long expected_key)
+{
+	std::ifstream fin(filename.c_str(), std::ios_base::binary);
+	if (!fin.is_open()) return false;
+
+	char magic[sizeof(STATE_MAGIC)];
+	boost::uint32_t version, key_low, key_high, group_count, point_count, shift_count;
+	if ( !fin.read(magic, sizeof(magic)) || memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0 ) return false;
+	if ( !ReadValue(fin, version) || version != STATE_VERSION ) return false;
+	if ( !ReadValue(fin, key_low) || !ReadValue(fin, key_high) ) return false;
+	if ( (static_cast<unsigned long long>(key_high) << 32 | key_low) != expected_key ) return false;
+	if ( !ReadValue(fin, group_count) || !ReadValue(fin, point_count) || !ReadValue(fin, shift_count) ) return false;
+
+	key = expected_key;
+	groups.clear();
+	desync_points.clear();
+	shifts.clear();
+
+	for (boost::uint32_t i = 0; i < group_count; ++i)
+	{
+		boost::uint32_t begin, end, offset;
+		if ( !ReadValue(fin, begin) || !ReadValue(fin, end) || !ReadValue(fin, offset) ) return false;
+		groups.push_back( Timing(begin, end, offset) );
+	}
+
+	// Точки нужны непустые и по возрастанию, иначе участки между ними не определены
+	size_t next_sync = 0, next_desync = 0;
+	for (boost::uint32_t i = 0; i < point_count; ++i)
+	{
+		boost::uint32_t sync_count, desync_count, value;
+		if ( !ReadValue(fin, sync_count) || !ReadValue(fin, desync_count) || sync_count == 0 || desync_count == 0 ) return false;
+		DesyncPositions sync, desync;
+		for (boost::uint32_t j = 0; j < sync_count; ++j)
+		{
+			if ( !ReadValue(fin, value) || value < next_sync ) return false;
+			sync.push_back(value);
+			next_sync = value + 1u;
+		}
+		for (boost::uint32_t j = 0; j < desync_count; ++j)
+		{
+			if ( !ReadValue(fin, value) || value < next_desync || value >= group_count ) return false;
+			desync.push_back(value);
+			next_desync = value + 1u;
+		}
+		desync_points.push_back( DesyncGroup(sync, desync) );
+	}
+
+	if (shift_count != desync_points.size() + LeadingSegments(desync_points)) return false;
+	for (boost::uint32_t i = 0; i < shift_count; ++i)
+	{
+		boost::uint32_t begin, end, shift;
+		if ( !ReadValue(fin, begin) || !ReadValue(fin, end) || !ReadValue(fin, shift) || begin > end || end > group_count ) return false;
+		shifts.push_back( SegmentShift(begin, end, static_cast<int>(shift)) );
+	}
+	return true;
+}
+
+/***********************************/
+/*   Пересчёт изменившихся точек   */
+/***********************************/
+static void MergePoints(DesyncGroup& first, const DesyncGroup& second)
+{
+	first.sync.insert(first.sync.end(), second.sync.begin(), second.sync.end());
+	first.desync.insert(first.desync.end(), second.desync.begin(), second.desync.end());
+}
+
+bool AlignIncremental(PhraseGroups& sync, PhraseGroups& desync, const AlignmentState& previous, const SyncParams& params,
+	DesyncGroups& desync_points, SegmentShifts& shifts, size_t& recomputed)
+{
+	typedef AlignmentState::Timing Timing;
+	const std::vector<Timing>& old_groups = previous.groups;
+	const DesyncGroups& old_points = previous.desync_points;
+	const size_t old_size = old_groups.size(), new_size = desync.size(), old_count = old_points.size();
+	recomputed = 0;
+
+	// Число синхронизированных групп в состоянии не хранится: точки за его пределами - от другого скрипта
+	if ( !old_points.empty() && old_points.back().sync.back() >= sync.size() ) return false;
+
+	// Совпадающие начало и конец рассинхронизированного скрипта
+	size_t prefix = 0, suffix = 0;
+	while ( prefix < old_size && prefix < new_size
+		&& old_groups[prefix] == Timing(desync[prefix].getBegin(), desync[prefix].getEnd(), desync[prefix].getOffset()) ) ++prefix;
+	while ( suffix < old_size - prefix && suffix < new_size - prefix
+		&& old_groups[old_size - 1 - suffix] == Timing(desync[new_size - 1 - suffix].getBegin(), desync[new_size - 1 - suffix].getEnd(), desync[new_size - 1 - suffix].getOffset()) ) ++suffix;
+
+	// Ничего не изменилось
+	if (prefix == old_size && old_size == new_size)
+	{
+		desync_points = old_points;
+		shifts = previous.shifts;
+		return true;
+	}
+
+	// Точки [0, a) целиком до изменений, [b, old_count) - целиком после
+	size_t a = 0, b = old_count;
+	while (a < old_count && old_points[a].desync.back() < prefix) ++a;
+	while (b > a && old_points[b - 1].desync[0] >= old_size - suffix) --b;
+
+	// Участок между ними начинается и кончается совпавшими группами
+	const size_t sync_begin = a > 0 ? old_points[a - 1].sync.back() + 1 : 0;
+	const size_t desync_begin = a > 0 ? old_points[a - 1].desync.back() + 1 : 0;
+	const size_t sync_end = b < old_count ? old_points[b].sync[0] : sync.size();
+	const size_t desync_end = b < old_count ? old_points[b].desync[0] + new_size - old_size : new_size;
+	if (sync_begin > sync_end || desync_begin > desync_end || sync_end > sync.size() || desync_end > new_size) return false;
+	if ((desync_end - desync_begin) * 2 > new_size) return false;
+
+	DesyncGroups window;
+	GetLCS(sync, sync_begin, sync_end, desync, desync_begin, desync_end, b < old_count, params, window);
+
+	// Точки на границах участка, вплотную прилегающие к соседним, при полном сопоставлении были бы одной
+	desync_points.assign(old_points.begin(), old_points.begin() + a);
+	size_t window_first = 0;
+	if ( a > 0 && !window.empty() && window.front().sync[0] == sync_begin && window.front().desync[0] == desync_begin )
+	{
+		MergePoints(desync_points.back(), window.front());
+		window_first = 1;
+	}
+	desync_points.insert(desync_points.end(), window.begin() + window_first, window.end());
+
+	// Точки после участка с поправкой на изменение числа групп
+	const size_t moved = new_size - old_size;
+	size_t suffix_start = 0, suffix_old_start = b;
+	for (size_t i = b; i < old_count; ++i)
+	{
+		DesyncGroup point = old_points[i];
+		for (DesyncPositions::iterator pos = point.desync.begin(); pos != point.desync.end(); ++pos)
+		{
+			*pos += moved;
+		}
+		if ( i == b && !desync_points.empty()
+			&& desync_points.back().sync.back() + 1 == point.sync[0] && desync_points.back().desync.back() + 1 == point.desync[0] )
+		{
+			MergePoints(desync_points.back(), point);
+			suffix_old_start = b + 1;
+			continue;
+		}
+		if (i == suffix_old_start) suffix_start = desync_points.size();
+		desync_points.push_back(point);
+	}
+	if (suffix_old_start >= old_count) suffix_start = desync_points.size();
+
+	// Сдвиги: до изменившихся точек - сохранённые, дальше - заново, пока у точки после участка
+	// не получится прежний сдвиг. Тогда и конец её участка прежний, и остальные сдвиги не изменятся.
+	shifts.clear();
+	if (desync_points.empty()) return true;
+	if (desync_points[0].desync[0] > 0)
+	{
+		shifts.push_back( SegmentShift(0, desync_points[0].desync[0], 0) );
+	}
+
+	const size_t old_lead = LeadingSegments(old_points);
+	const size_t first_changed = a > 0 ? a - 1 : 0;
+	unsigned int prev_end = 0;
+	bool reuse = false;
+	for (size_t i = 0; i < desync_points.size(); ++i)
+	{
+		const size_t old_index = i - suffix_start + suffix_old_start;
+		if (i < first_changed)
+		{
+			shifts.push_back( previous.shifts[old_lead + i] );
+		}
+		else if (reuse)
+		{
+			SegmentShift segment = previous.shifts[old_lead + old_index];
+			segment.begin += moved;
+			segment.end += moved;
+			shifts.push_back(segment);
+		}
+		else
+		{
+			shifts.push_back( SyncronizePoint(sync, desync, desync_points, i, prev_end, params) );
+			++recomputed;
+			reuse = i >= suffix_start && shifts.back().shift == previous.shifts[old_lead + old_index].shift;
+		}
+		prev_end = SegmentEnd(desync, shifts.back());
+	}
+	return true;
+}
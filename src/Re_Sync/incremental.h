@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+#include "structure.h"
+#include "resync.h"
+
+
+/*******************************************/
+/*   Сохранённое состояние сопоставления   */
+/*******************************************/
+// Группы рассинхронизированного скрипта, точки рассинхронизации и сдвиги прошлого запуска.
+// key - хэш синхронизированного скрипта и всех параметров, от которых зависит результат.
+class AlignmentState
+{
+public:
+	class Timing
+	{
+	public:
+		Timing(unsigned int begin, unsigned int end, unsigned int offset) : begin(begin), end(end), offset(offset) {};
+		bool operator==(const Timing& other) const { return begin == other.begin && end == other.end && offset == other.offset; }
+		unsigned int begin, end, offset;
+	};
+
+	AlignmentState() : key(0) {};
+	AlignmentState(unsigned long long key, const PhraseGroups& desync, const DesyncGroups& desync_points, const SegmentShifts& shifts);
+
+	// false - файла нет, он повреждён или записан с другим ключом
+	bool Load(const std::string& filename, unsigned long long expected_key);
+	void Save(const std::string& filename) const;
+
+	unsigned long long key;
+	std::vector<Timing> groups;
+	DesyncGroups desync_points;
+	SegmentShifts shifts;
+};
+
+// Пересчёт только тех точек рассинхронизации, группы которых изменились с прошлого запуска:
+// НОП на участке между неизменными началом и концом, сдвиги - для изменившихся точек и соседних,
+// пока они отличаются от сохранённых. false - изменилась большая часть скрипта,
+// быстрее сопоставить заново. recomputed - сколько точек посчитано заново.
+bool AlignIncremental(PhraseGroups& sync, PhraseGroups& desync, const AlignmentState& previous, const SyncParams& params,
+	DesyncGroups& desync_points, SegmentShifts& shifts, size_t& recomputed);
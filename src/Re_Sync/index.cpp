@@ -0,0 +1,179 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "exception.h"
+#include "index.h"
+
+
+static const char INDEX_MAGIC[8] = {'R', 'E', 'S', 'Y', 'N', 'C', 'I', 'X'};
+static const boost::uint32_t INDEX_VERSION = 3;
+static const boost::uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
+static void ThrowIndexError(const char* what, const std::wstring& message)
+{
+	BOOST_THROW_EXCEPTION(
+		boost::enable_error_info(std::runtime_error(what))
+		<< error_message(message)
+	);
+}
+
+static boost::uint32_t IndexFlags(const SyncParams& params)
+{
+	return (params.skip_lyrics ? INDEX_SKIP_LYRICS : 0) | (params.no_skip ? INDEX_NO_SKIP : 0) | (params.allow_overlap ? INDEX_ALLOW_OVERLAP : 0);
+}
+
+/**************/
+/*   Запись   */
+/**************/
+void WriteReferenceIndex(const std::string& filename, const PhraseGroups& groups, const SyncParams& params,
+	unsigned long long keywords_hash, unsigned long long source_size, unsigned long long source_hash)
+{
+	ReferenceIndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+	header.version = INDEX_VERSION;
+	header.byte_order = INDEX_BYTE_ORDER;
+	header.count = static_cast<boost::uint32_t>(groups.size());
+	header.min_duration = params.min_duration;
+	header.max_offset = params.max_offset;
+	header.max_desync = params.max_desync;
+	header.max_shift = params.max_shift;
+	header.flags = IndexFlags(params);
+	header.source_size = source_size;
+	header.source_hash = source_hash;
+	header.keywords_hash = keywords_hash;
+
+	std::vector<boost::uint32_t> data(groups.size() * 3u);
+	for (size_t i = 0; i < groups.size(); ++i)
+	{
+		data[i] = groups[i].getBegin();
+		data[groups.size() + i] = groups[i].getEnd();
+		data[groups.size() * 2u + i] = groups[i].getOffset();
+	}
+
+	std::ofstream fout(filename.c_str(), std::ios_base::binary);
+	if (!fout.is_open())
+	{
+		ThrowIndexError("Can't open file for writing", L"Ошибка открытия файла для записи");
+	}
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!data.empty()) fout.write(reinterpret_cast<const char*>(&data[0]), data.size() * sizeof(data[0]));
+	fout.close();
+	if (!fout)
+	{
+		ThrowIndexError("Index write error", L"Ошибка записи индекса");
+	}
+}
+
+/**************/
+/*   Чтение   */
+/**************/
+bool IsReferenceIndex(const std::string& filename)
+{
+	char magic[sizeof(INDEX_MAGIC)];
+	std::ifstream fin(filename.c_str(), std::ios_base::binary);
+	return fin.read(magic, sizeof(magic)) && memcmp(magic, INDEX_MAGIC, sizeof(magic)) == 0;
+}
+
+void CheckReferenceIndex(const ReferenceIndexHeader& header, size_t size, const SyncParams& params, unsigned long long keywords_hash)
+{
+	if (memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 || header.byte_order != INDEX_BYTE_ORDER)
+	{
+		ThrowIndexError("Not an index", L"Файл не является индексом или записан на машине с другим порядком байт");
+	}
+	if (header.version != INDEX_VERSION)
+	{
+		ThrowIndexError("Index version not supported", L"Версия индекса не поддерживается");
+	}
+	if (size != sizeof(header) + static_cast<size_t>(header.count) * 3u * sizeof(boost::uint32_t))
+	{
+		ThrowIndexError("Wrong index size", L"Индекс повреждён");
+	}
+	// От остальных параметров группы не зависят. Таблица ключевых слов решает, какие фразы отброшены.
+	const boost::uint32_t grouping_flags = INDEX_SKIP_LYRICS | INDEX_NO_SKIP;
+	if ( header.min_duration != params.min_duration || header.max_offset != params.max_offset
+		|| (header.flags & grouping_flags) != (IndexFlags(params) & grouping_flags)
+		|| header.keywords_hash != keywords_hash )
+	{
+		ThrowIndexError("Index parameters mismatch", L"Индекс построен с другими параметрами группировки");
+	}
+}
+
+void LoadReferenceIndex(const std::string& filename, const SyncParams& params, unsigned long long keywords_hash,
+	PhraseGroups& groups, ReferenceIndexHeader* header)
+{
+	namespace bip = boost::interprocess;
+
+	bip::mapped_region region;
+	try
+	{
+		bip::file_mapping file(filename.c_str(), bip::read_only);
+		bip::mapped_region(file, bip::read_only).swap(region);
+	}
+	catch (const bip::interprocess_exception&)
+	{
+		ThrowIndexError("Can't map index", L"Ошибка открытия индекса");
+	}
+
+	LoadReferenceIndex(static_cast<const char*>(region.get_address()), region.get_size(), params, keywords_hash, groups, header);
+}
+
+bool IsReferenceIndex(const char* data, size_t size)
+{
+	return size >= sizeof(INDEX_MAGIC) && memcmp(data, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+}
+
+void LoadReferenceIndex(const char* data, size_t size, const SyncParams& params, unsigned long long keywords_hash,
+	PhraseGroups& groups, ReferenceIndexHeader* header)
+{
+	ReferenceIndexHeader head;
+	if (size < sizeof(head))
+	{
+		ThrowIndexError("Index too small", L"Индекс повреждён");
+	}
+	memcpy(&head, data, sizeof(head));
+
+	CheckReferenceIndex(head, size, params, keywords_hash);
+
+	// Выравнивание массивов обеспечено размером заголовка
+	const boost::uint32_t* begins = reinterpret_cast<const boost::uint32_t*>(data + sizeof(head));
+	const boost::uint32_t* ends = begins + head.count;
+	const boost::uint32_t* offsets = ends + head.count;
+
+	std::shared_ptr<PhrasesPtrVector> no_phrases(new PhrasesPtrVector);
+	groups.clear();
+	groups.reserve(head.count);
+	for (boost::uint32_t i = 0; i < head.count; ++i)
+	{
+		groups.push_back( PhraseGroup(begins[i], ends[i], offsets[i], no_phrases, 0, 0) );
+	}
+
+	if (groups.empty())
+	{
+		ThrowIndexError("Phrase groups has not been formed", L"Не сформировано ни одной группы");
+	}
+	if (header != nullptr) *header = head;
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+#include "nullptr.h"
+#include "structure.h"
+#include "resync.h"
+
+
+/********************************************/
+/*   Заголовок индекса эталонного скрипта   */
+/********************************************/
+// Файл - заголовок и три массива по count значений: начала, концы и отступы групп.
+// Всё в порядке байт записавшей машины, поэтому файл можно отобразить в память как есть.
+struct ReferenceIndexHeader
+{
+	char magic[8];
+	boost::uint32_t version;
+	boost::uint32_t byte_order; // 0x01020304 в порядке байт записавшей машины
+	boost::uint32_t count;
+	boost::int32_t min_duration, max_offset, max_desync, max_shift;
+	boost::uint32_t flags; // INDEX_SKIP_LYRICS, INDEX_NO_SKIP, INDEX_ALLOW_OVERLAP
+	boost::uint64_t source_size, source_hash; // XXHash64 исходного текста, как у кэша результатов
+	boost::uint64_t keywords_hash; // Таблица ключевых слов, как KeywordsHash: 0 - встроенная
+};
+
+enum {INDEX_SKIP_LYRICS = 1, INDEX_NO_SKIP = 2, INDEX_ALLOW_OVERLAP = 4};
+
+void WriteReferenceIndex(const std::string& filename, const PhraseGroups& groups, const SyncParams& params,
+	unsigned long long keywords_hash, unsigned long long source_size, unsigned long long source_hash);
+bool IsReferenceIndex(const std::string& filename);
+// Исключение, если заголовок индекса размером size байт повреждён или индекс построен
+// с другими параметрами группировки или другой таблицей ключевых слов.
+void CheckReferenceIndex(const ReferenceIndexHeader& header, size_t size, const SyncParams& params, unsigned long long keywords_hash);
+// Группы из отображённого в память индекса, проверенного CheckReferenceIndex.
+// У групп нет фраз - сдвигать их нельзя.
+void LoadReferenceIndex(const std::string& filename, const SyncParams& params, unsigned long long keywords_hash,
+	PhraseGroups& groups, ReferenceIndexHeader* header = nullptr);
+// То же для индекса, уже прочитанного в память; data выровнены хотя бы на 4 байта
+bool IsReferenceIndex(const char* data, size_t size);
+void LoadReferenceIndex(const char* data, size_t size, const SyncParams& params, unsigned long long keywords_hash,
+	PhraseGroups& groups, ReferenceIndexHeader* header = nullptr);
@@ -0,0 +1,196 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <deque>
+#include <fstream>
+
+#include "nullptr.h"
+#include "exception.h"
+#include "filter.h"
+
+
+// Английские, русские и названия стилей
+static const wchar_t* const COMMENTARY_KEYWORDS[] = {
+	L"translate", L"translator", L"translation",
+	L"timed", L"timer", L"timing", L"typesetted", L"typesetter", L"typesetting",
+	L"encoded", L"encoder", L"encoding", L"styled", L"styler", L"styling",
+	L"karaoke", L"note", L"qc",
+	L"перевод", L"тайминг", L"стайлинг", L"тайпсет", L"енкод", L"энкод", L"кодирование", L"оформление",
+	L"редактор", L"редактирование", L"редактура", L"редакция", L"караоке", L"коммент",
+	L"title", L"comment", L"sign", L"logo", L"insert", L"copyright", L"name", L"credit"
+};
+
+static const wchar_t* const LYRICS_KEYWORDS[] = {
+	L"op ", L"op_", L"op,", L"op-", L"ed ", L"ed_", L"ed,", L"ed-", L"opening", L"ending"
+};
+
+void AddDefaultKeywords(KeywordFilter& filter)
+{
+	for (size_t i = 0; i < sizeof(COMMENTARY_KEYWORDS) / sizeof(COMMENTARY_KEYWORDS[0]); ++i)
+	{
+		filter.AddKeyword(COMMENTARY_KEYWORDS[i], KEYWORD_COMMENTARY);
+	}
+	for (size_t i = 0; i < sizeof(LYRICS_KEYWORDS) / sizeof(LYRICS_KEYWORDS[0]); ++i)
+	{
+		filter.AddKeyword(LYRICS_KEYWORDS[i], KEYWORD_LYRICS);
+	}
+}
+
+void KeywordFilter::AddKeyword(const std::wstring& keyword, unsigned char kind)
+{
+	if ( keyword.empty() ) return;
+
+	std::wstring folded(keyword);
+	for (std::wstring::iterator it = folded.begin(); it != folded.end(); ++it)
+	{
+		*it = FoldCase(*it);
+	}
+	_keywords.push_back(folded);
+	_kinds.push_back(kind);
+}
+
+void KeywordFilter::Compile()
+{
+	// Каждый символ, встречающийся в словах, получает свой класс; остальные - класс 0
+	unsigned int classes = 1;
+	_ascii_class.assign(ASCII_SIZE, 0);
+	_cyrillic_class.assign(CYRILLIC_SIZE, 0);
+	for (std::vector<std::wstring>::const_iterator it = _keywords.begin(); it != _keywords.end(); ++it)
+	{
+		for (std::wstring::const_iterator ch = it->begin(); ch != it->end(); ++ch)
+		{
+			unsigned char* cls = nullptr;
+			if (*ch >= 0 && static_cast<unsigned int>(*ch) < ASCII_SIZE) cls = &_ascii_class[*ch];
+			else if (static_cast<unsigned int>(*ch) >= CYRILLIC_FIRST && static_cast<unsigned int>(*ch) < CYRILLIC_FIRST + CYRILLIC_SIZE) cls = &_cyrillic_class[*ch - CYRILLIC_FIRST];
+			else continue; // Такой символ не может встретиться в тексте после приведения
+
+			if (*cls == 0)
+			{
+				if (classes > 0xFF)
+				{
+					BOOST_THROW_EXCEPTION(
+						boost::enable_error_info(std::runtime_error("Too many distinct keyword characters"))
+						<< error_message(L"Слишком много различных символов в ключевых словах")
+					);
+				}
+				*cls = static_cast<unsigned char>(classes++);
+			}
+		}
+	}
+	_tables.ascii_class = &_ascii_class[0];
+	_tables.cyrillic_class = &_cyrillic_class[0];
+
+	// Бор
+	_next.assign(classes, 0);
+	_output.assign(1, 0);
+	for (size_t i = 0; i < _keywords.size(); ++i)
+	{
+		unsigned int state = 0;
+		bool valid = true;
+		for (std::wstring::const_iterator ch = _keywords[i].begin(); ch != _keywords[i].end(); ++ch)
+		{
+			unsigned int cls = Classify(*ch);
+			if (cls == 0) { valid = false; break; }
+
+			unsigned int& next = _next[state * classes + cls];
+			if (next == 0)
+			{
+				next = static_cast<unsigned int>(_output.size());
+				_output.push_back(0);
+				_next.resize(_next.size() + classes, 0);
+			}
+			state = _next[state * classes + cls];
+		}
+		if (valid) _output[state] |= _kinds[i];
+	}
+
+	// Суффиксные ссылки; недостающие переходы заменяются переходами по ним (ДКА)
+	std::vector<unsigned int> fail(_output.size(), 0);
+	std::deque<unsigned int> queue;
+	for (unsigned int cls = 0; cls < classes; ++cls)
+	{
+		if (_next[cls] != 0) queue.push_back(_next[cls]);
+	}
+	while ( !queue.empty() )
+	{
+		unsigned int state = queue.front();
+		queue.pop_front();
+		_output[state] |= _output[fail[state]];
+
+		for (unsigned int cls = 0; cls < classes; ++cls)
+		{
+			unsigned int& next = _next[state * classes + cls];
+			if (next != 0)
+			{
+				fail[next] = _next[fail[state] * classes + cls];
+				queue.push_back(next);
+			}
+			else
+			{
+				next = _next[fail[state] * classes + cls];
+			}
+		}
+	}
+
+	Attach(classes);
+}
+
+/*********************************/
+/*   Запись таблиц в файл (LE)   */
+/*********************************/
+inline void WriteUInt(std::ostream& out, unsigned int value)
+{
+	const char bytes[4] = {
+		static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF),
+		static_cast<char>((value >> 16) & 0xFF), static_cast<char>((value >> 24) & 0xFF)
+	};
+	out.write(bytes, 4);
+}
+
+void KeywordFilter::Save(const std::string& filename) const
+{
+	std::ofstream fout(filename.c_str(), std::ios_base::binary);
+	if (!fout.is_open())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Сan't open file for writing"))
+			<< error_message(L"Ошибка открытия файла для записи")
+		);
+	}
+
+	fout.write(KEYWORD_TABLE_MAGIC, 4);
+	WriteUInt(fout, KEYWORD_TABLE_VERSION);
+	WriteUInt(fout, _tables.classes);
+	WriteUInt(fout, _tables.states);
+	fout.write(reinterpret_cast<const char*>(_tables.ascii_class), ASCII_SIZE);
+	fout.write(reinterpret_cast<const char*>(_tables.cyrillic_class), CYRILLIC_SIZE);
+	for (unsigned int i = 0; i < _tables.states * _tables.classes; ++i)
+	{
+		WriteUInt(fout, _tables.next[i]);
+	}
+	fout.write(reinterpret_cast<const char*>(_tables.output), _tables.states);
+
+	if (!fout.good())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Can't write keyword table"))
+			<< error_message(L"Ошибка записи таблицы ключевых слов")
+		);
+	}
+}
@@ -0,0 +1,244 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "nullptr.h"
+#include "exception.h"
+#include "libresync.h"
+#include "script.h"
+#include "engine.h"
+
+#ifdef __GNUC__
+# include "unix/io.h"
+#else
+# include "windows/io.h"
+#endif
+
+
+/***************************************/
+/*   Скрипт с результатами и ошибкой   */
+/***************************************/
+struct resync_script
+{
+	resync_script() : has_output(false) {};
+
+	std::unique_ptr<SubtitleScript> script;
+	std::vector<resync_shift> shifts;
+	std::string output; // Последний вывод resync_render
+	bool has_output;
+	std::string error;
+};
+
+// Ошибки не выходят за пределы библиотеки
+static int Fail(resync_script* script, const char* message)
+{
+	script->error = message;
+	return RESYNC_ERROR;
+}
+
+void resync_default_params(resync_params* params)
+{
+	if (params == nullptr) return;
+
+	SyncParams defaults;
+	EngineOptions options;
+	params->min_duration = defaults.min_duration;
+	params->max_offset = defaults.max_offset;
+	params->max_desync = defaults.max_desync;
+	params->max_shift = defaults.max_shift;
+	params->skip_lyrics = defaults.skip_lyrics;
+	params->no_skip = defaults.no_skip;
+	params->allow_overlap = defaults.allow_overlap;
+	params->engine = nullptr;
+	params->memory_budget = options.memory_budget;
+}
+
+resync_script* resync_create(void)
+{
+	try
+	{
+		return new resync_script;
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void resync_destroy(resync_script* script)
+{
+	delete script;
+}
+
+/**************/
+/*   Разбор   */
+/**************/
+int resync_load(resync_script* script, const char* data, size_t size)
+{
+	if (script == nullptr) return RESYNC_INVALID_ARGUMENT;
+	if (data == nullptr && size > 0) return Fail(script, "No data");
+
+	script->script.reset();
+	script->shifts.clear();
+	script->has_output = false;
+	script->error.clear();
+	try
+	{
+		std::wstring content;
+		io::Decode(data, size, content);
+
+		std::unique_ptr<SubtitleScript> loaded(new SubtitleScript);
+		loaded->Load(content);
+		script->script = std::move(loaded);
+	}
+	catch (const std::exception& e)
+	{
+		return Fail(script, e.what());
+	}
+	catch (...)
+	{
+		return Fail(script, "Unknown error");
+	}
+
+	return RESYNC_OK;
+}
+
+/*********************/
+/*   Синхронизация   */
+/*********************/
+int resync_align(resync_script* sync, resync_script* desync, const resync_params* params)
+{
+	if (sync == nullptr || desync == nullptr || sync == desync) return RESYNC_INVALID_ARGUMENT;
+	if (!sync->script || !desync->script) return Fail(desync, "Script is not loaded");
+
+	resync_params defaults;
+	if (params == nullptr)
+	{
+		resync_default_params(&defaults);
+		params = &defaults;
+	}
+
+	SyncParams sync_params;
+	sync_params.min_duration = params->min_duration;
+	sync_params.max_offset = params->max_offset;
+	sync_params.max_desync = params->max_desync;
+	sync_params.max_shift = params->max_shift;
+	sync_params.skip_lyrics = params->skip_lyrics != 0;
+	sync_params.no_skip = params->no_skip != 0;
+	sync_params.allow_overlap = params->allow_overlap != 0;
+
+	EngineOptions options;
+	options.memory_budget = params->memory_budget;
+
+	desync->error.clear();
+	try
+	{
+		AlignmentEnginePtr engine = CreateEngine(params->engine != nullptr ? params->engine : "auto", options);
+
+		PhraseGroups sync_groups, desync_groups;
+		sync->script->Group(sync_params, sync_groups);
+		desync->script->Group(sync_params, desync_groups);
+
+		DesyncGroups desync_points;
+		SegmentShifts shifts;
+		engine->Align(sync_groups, desync_groups, sync_params, desync_points, shifts);
+
+		// Время участков - до сдвига, поэтому запоминается раньше, чем сдвигаются фразы
+		desync->shifts.clear();
+		for (SegmentShifts::const_iterator it = shifts.begin(); it != shifts.end(); ++it)
+		{
+			resync_shift shift = {desync_groups[it->begin].getBegin(), desync_groups[it->end - 1].getEnd(), it->shift};
+			desync->shifts.push_back(shift);
+		}
+
+		PhraseGroups result;
+		desync->script->Shift(desync_groups, shifts, result);
+		desync->has_output = false;
+	}
+	catch (const std::exception& e)
+	{
+		return Fail(desync, e.what());
+	}
+	catch (...)
+	{
+		return Fail(desync, "Unknown error");
+	}
+
+	return RESYNC_OK;
+}
+
+size_t resync_get_shifts(const resync_script* script, resync_shift* shifts, size_t count)
+{
+	if (script == nullptr) return 0;
+
+	if (shifts != nullptr)
+	{
+		for (size_t i = 0; i < count && i < script->shifts.size(); ++i)
+		{
+			shifts[i] = script->shifts[i];
+		}
+	}
+	return script->shifts.size();
+}
+
+/*************/
+/*   Вывод   */
+/*************/
+int resync_render(resync_script* script, char* buffer, size_t* size)
+{
+	if (script == nullptr || size == nullptr) return RESYNC_INVALID_ARGUMENT;
+	if (!script->script) return Fail(script, "Script is not loaded");
+
+	// Запрос длины и вывод обычно идут подряд, поэтому текст генерируется один раз
+	if (!script->has_output)
+	{
+		try
+		{
+			std::wstring content;
+			script->script->Generate(content);
+			io::Encode(content, script->output);
+			script->has_output = true;
+		}
+		catch (const std::exception& e)
+		{
+			return Fail(script, e.what());
+		}
+		catch (...)
+		{
+			return Fail(script, "Unknown error");
+		}
+	}
+
+	const size_t capacity = *size;
+	*size = script->output.size();
+	if (buffer == nullptr) return RESYNC_OK;
+	if (capacity < script->output.size()) return RESYNC_BUFFER_TOO_SMALL;
+
+	memcpy(buffer, script->output.data(), script->output.size());
+	return RESYNC_OK;
+}
+
+const char* resync_error(const resync_script* script)
+{
+	return script == nullptr ? "" : script->error.c_str();
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+/*
+ * libresync: синхронизация субтитров внутри процесса.
+ * Интерфейс на C; строки с ошибками - английские, в ASCII.
+ * Разные скрипты можно обрабатывать в разных потоках одновременно,
+ * один и тот же скрипт - только в одном потоке.
+ * Библиотека не меняет глобальную локаль.
+ */
+
+#include <stddef.h>
+
+#if defined _WIN32 && defined RESYNC_DLL
+# ifdef RESYNC_BUILD
+#  define RESYNC_API __declspec(dllexport)
+# else
+#  define RESYNC_API __declspec(dllimport)
+# endif
+#elif defined __GNUC__ && __GNUC__ >= 4
+# define RESYNC_API __attribute__((visibility("default")))
+#else
+# define RESYNC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Коды возврата */
+enum
+{
+	RESYNC_OK = 0,
+	RESYNC_ERROR = -1,            /* Ошибка разбора, группировки или сопоставления, см. resync_error */
+	RESYNC_BUFFER_TOO_SMALL = -2, /* Нужный размер буфера записан в *size */
+	RESYNC_INVALID_ARGUMENT = -3
+};
+
+/* Скрипт SRT или ASS */
+typedef struct resync_script resync_script;
+
+/* Параметры синхронизации, как у ключей Re_Sync */
+typedef struct resync_params
+{
+	int min_duration, max_offset, max_desync, max_shift; /* В милисекундах */
+	int skip_lyrics, no_skip, allow_overlap;
+	const char* engine; /* auto, lcs, dtw, seed, anchors; NULL - auto */
+	unsigned long long memory_budget; /* Для auto, в байтах */
+} resync_params;
+
+/* Сдвиг участка рассинхронизированного скрипта */
+typedef struct resync_shift
+{
+	unsigned int begin, end; /* Время участка до сдвига, мс */
+	int shift;
+} resync_shift;
+
+RESYNC_API void resync_default_params(resync_params* params);
+
+RESYNC_API resync_script* resync_create(void);
+RESYNC_API void resync_destroy(resync_script* script);
+
+/* Разбор из памяти; кодировка определяется по BOM, без BOM - CP1251 */
+RESYNC_API int resync_load(resync_script* script, const char* data, size_t size);
+
+/* Подгонка тайминга desync по sync; params может быть NULL */
+RESYNC_API int resync_align(resync_script* sync, resync_script* desync, const resync_params* params);
+
+/* Сдвиги последнего resync_align; копируется не больше count, возвращается общее число */
+RESYNC_API size_t resync_get_shifts(const resync_script* script, resync_shift* shifts, size_t count);
+
+/* Текст скрипта в UTF-8 с BOM. *size - размер буфера на входе и длина текста на выходе;
+   с buffer == NULL возвращается только длина */
+RESYNC_API int resync_render(resync_script* script, char* buffer, size_t* size);
+
+/* Последняя ошибка операции со скриптом; для resync_align - у desync */
+RESYNC_API const char* resync_error(const resync_script* script);
+
+#ifdef __cplusplus
+}
+#endif
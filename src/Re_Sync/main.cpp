@@ -29,19 +29,37 @@
 #include <cstdlib>
 #include <locale>
 #include <iostream>
+#include <memory>
+
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
 
 #include "nullptr.h"
 #include "exception.h"
 #include "format.h"
 #include "structure.h"
 #include "resync.h"
+#include "engine.h"
+#include "tune.h"
+#include "script.h"
+#include "batch.h"
+#include "index.h"
+#include "hash.h"
+#include "cache.h"
+#include "incremental.h"
+#include "shiftmap.h"
+#include "threadpool.h"
 
 #ifdef __GNUC__
 # include <getopt.h>
 # include "unix/io.h"
+# include "unix/server.h"
+# include "unix/watch.h"
 #else
 # include "glibc/getopt.h"
 # include "windows/io.h"
+# include "windows/server.h"
+# include "windows/watch.h"
 #endif
 
 #ifdef _MSC_VER
@@ -50,16 +68,13 @@
 # define CONSOLE_LOCALE ""
 #endif
 
-// В милисекундах
-int MIN_DURATION = 500;
-int MAX_OFFSET = 5000;
-int MAX_DESYNC = 200;
-int MAX_SHIFT = 15000;
-bool SKIP_LYRICS = false;
-bool NO_SKIP = false;
-bool ALLOW_OVERLAP = false;
-
 void PrintHelp(char exec_name[]);
+void PrintFormat(format::Format format);
+void LoadScript(const std::string& filename, SubtitleScript* script, const SyncParams& params, PhraseGroups* groups, unsigned long long* hash);
+void LoadReference(const std::string& filename, SubtitleScript* script, const SyncParams& params, unsigned long long keywords_hash,
+	PhraseGroups* groups, bool* indexed, unsigned long long* hash);
+unsigned long long KeywordsHash(const std::string& keywords_name);
+void EmitShiftMap(const std::string& filename, const PhraseGroups& desync_groups, const PhrasesPtrVector& phrases, const SegmentShifts& shifts, bool verbose);
 
 
 int main(int argc, char* argv[])
@@ -68,8 +83,10 @@ int main(int argc, char* argv[])
 	std::locale::global( std::locale(CONSOLE_LOCALE) );
 
 	// Обработка параметров
-	bool verbose = false, generate_svg = false;
-	std::string sync_name, desync_name, out_name, svg_name = "graph.svg";
+	bool verbose = false, generate_svg = false, benchmark = false, auto_tune = false, watch = false;
+	std::string sync_name, desync_name, out_name, svg_name = "graph.svg", engine_name = "auto", keywords_name, batch_name, serve_name, client_name, index_name, cache_name, state_name, emit_shiftmap_name, apply_shiftmap_name;
+	EngineOptions engine_options;
+	SyncParams params;
 
 #ifdef _DEBUG
 	sync_name = "sync.ass"; desync_name = "desync.ass"; out_name = "output.ass";
@@ -78,7 +95,7 @@ int main(int argc, char* argv[])
 	{
 		const char* short_options = "hvs:d:o:g::";
 
-		enum {CODE_MIN_DURATION = 1000, CODE_MAX_OFFSET, CODE_MAX_DESYNC, CODE_MAX_SHIFT, CODE_SKIP_LYRICS, CODE_NO_SKIP, CODE_ALLOW_OVERLAP};
+		enum {CODE_MIN_DURATION = 1000, CODE_MAX_OFFSET, CODE_MAX_DESYNC, CODE_MAX_SHIFT, CODE_SKIP_LYRICS, CODE_NO_SKIP, CODE_ALLOW_OVERLAP, CODE_ENGINE, CODE_MEMORY_BUDGET, CODE_BENCHMARK, CODE_KEYWORDS, CODE_AUTO_TUNE, CODE_BATCH, CODE_SERVE, CODE_CLIENT, CODE_WRITE_INDEX, CODE_CACHE, CODE_STATE, CODE_WATCH, CODE_EMIT_SHIFTMAP, CODE_APPLY_SHIFTMAP};
 		const struct option long_options[] = {
 			{"help",         no_argument,       nullptr, 'h'},
 			{"verbose",      no_argument,       nullptr, 'v'},
@@ -93,6 +110,20 @@ int main(int argc, char* argv[])
 			{"skip-lyrics",  no_argument,       nullptr, CODE_SKIP_LYRICS},
 			{"no-skip",      no_argument,       nullptr, CODE_NO_SKIP},
 			{"allow-overlap",no_argument,       nullptr, CODE_ALLOW_OVERLAP},
+			{"engine",       required_argument, nullptr, CODE_ENGINE},
+			{"memory-budget",required_argument, nullptr, CODE_MEMORY_BUDGET},
+			{"benchmark",    no_argument,       nullptr, CODE_BENCHMARK},
+			{"keywords",     required_argument, nullptr, CODE_KEYWORDS},
+			{"auto-tune",    no_argument,       nullptr, CODE_AUTO_TUNE},
+			{"batch",        required_argument, nullptr, CODE_BATCH},
+			{"serve",        required_argument, nullptr, CODE_SERVE},
+			{"client",       required_argument, nullptr, CODE_CLIENT},
+			{"write-index",  required_argument, nullptr, CODE_WRITE_INDEX},
+			{"cache",        required_argument, nullptr, CODE_CACHE},
+			{"state",        required_argument, nullptr, CODE_STATE},
+			{"watch",        no_argument,       nullptr, CODE_WATCH},
+			{"emit-shiftmap", required_argument, nullptr, CODE_EMIT_SHIFTMAP},
+			{"apply-shiftmap", required_argument, nullptr, CODE_APPLY_SHIFTMAP},
 			{nullptr, 0, nullptr, 0}
 		};
 
@@ -133,7 +164,7 @@ int main(int argc, char* argv[])
 				value = atoi(optarg);
 				if (value >= 0)
 				{
-					MIN_DURATION = value;
+					params.min_duration = value;
 				}
 				else
 				{
@@ -145,7 +176,7 @@ int main(int argc, char* argv[])
 				value = atoi(optarg);
 				if (value >= 0)
 				{
-					MAX_OFFSET = value;
+					params.max_offset = value;
 				}
 				else
 				{
@@ -157,7 +188,7 @@ int main(int argc, char* argv[])
 				value = atoi(optarg);
 				if (value >= 0)
 				{
-					MAX_DESYNC = value;
+					params.max_desync = value;
 				}
 				else
 				{
@@ -169,7 +200,7 @@ int main(int argc, char* argv[])
 				value = atoi(optarg);
 				if (value >= 0)
 				{
-					MAX_SHIFT = value;
+					params.max_shift = value;
 				}
 				else
 				{
@@ -178,15 +209,79 @@ int main(int argc, char* argv[])
 				break;
 
 			case CODE_SKIP_LYRICS:
-				SKIP_LYRICS = true;
+				params.skip_lyrics = true;
 				break;
 
 			case CODE_NO_SKIP:
-				NO_SKIP = true;
+				params.no_skip = true;
 				break;
 
 			case CODE_ALLOW_OVERLAP:
-				ALLOW_OVERLAP = true;
+				params.allow_overlap = true;
+				break;
+
+			case CODE_ENGINE:
+				engine_name = optarg;
+				break;
+
+			case CODE_MEMORY_BUDGET:
+				value = atoi(optarg);
+				if (value > 0)
+				{
+					engine_options.memory_budget = static_cast<unsigned long long>(value) << 20;
+				}
+				else
+				{
+					std::wclog << L"Бюджет памяти должен быть положительным" << std::endl;
+				}
+				break;
+
+			case CODE_BENCHMARK:
+				benchmark = true;
+				break;
+
+			case CODE_KEYWORDS:
+				keywords_name = optarg;
+				break;
+
+			case CODE_AUTO_TUNE:
+				auto_tune = true;
+				break;
+
+			case CODE_BATCH:
+				batch_name = optarg;
+				break;
+
+			case CODE_SERVE:
+				serve_name = optarg;
+				break;
+
+			case CODE_CLIENT:
+				client_name = optarg;
+				break;
+
+			case CODE_WRITE_INDEX:
+				index_name = optarg;
+				break;
+
+			case CODE_CACHE:
+				cache_name = optarg;
+				break;
+
+			case CODE_STATE:
+				state_name = optarg;
+				break;
+
+			case CODE_WATCH:
+				watch = true;
+				break;
+
+			case CODE_EMIT_SHIFTMAP:
+				emit_shiftmap_name = optarg;
+				break;
+
+			case CODE_APPLY_SHIFTMAP:
+				apply_shiftmap_name = optarg;
 				break;
 
 			default:
@@ -196,125 +291,215 @@ int main(int argc, char* argv[])
 	}
 #endif
 
-	if (sync_name.empty())
+	// Пакету и демону скрипты передаются иначе, для индекса нужен только синхронизированный,
+	// карта сдвигов применяется без него
+	const bool apply = !apply_shiftmap_name.empty();
+	const bool single = batch_name.empty() && serve_name.empty() && !apply;
+	const bool pair = single && index_name.empty();
+	if (single && sync_name.empty())
 	{
 		std::wcerr << L"Не указан синхронизированный скрипт\n" << std::endl;
 		PrintHelp(argv[0]);
 		return EXIT_FAILURE;
 	}
-	if (desync_name.empty())
+	if (pair && desync_name.empty())
 	{
 		std::wcerr << L"Не указан рассинхронизированный скрипт\n" << std::endl;
 		PrintHelp(argv[0]);
 		return EXIT_FAILURE;
 	}
-	if (out_name.empty())
+	if (apply && desync_name.empty())
+	{
+		std::wcerr << L"Не указан рассинхронизированный скрипт\n" << std::endl;
+		PrintHelp(argv[0]);
+		return EXIT_FAILURE;
+	}
+	// Если нужна только карта сдвигов, скрипт можно не выводить
+	if ((pair || apply) && out_name.empty() && (emit_shiftmap_name.empty() || watch || apply))
 	{
 		std::wcerr << L"Не указан выходной скрипт\n" << std::endl;
 		PrintHelp(argv[0]);
 		return EXIT_FAILURE;
 	}
 
+	// Стандартный ввод один
+	if (io::IsStandardStream(sync_name) && io::IsStandardStream(desync_name))
+	{
+		std::wcerr << L"Из стандартного ввода можно читать только один скрипт\n" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Иначе каждый вывод снова запускал бы синхронизацию
+	if (watch && out_name == desync_name)
+	{
+		std::wcerr << L"При слежении выходной скрипт должен отличаться от рассинхронизированного\n" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (watch && io::IsStandardStream(desync_name))
+	{
+		std::wcerr << L"Следить можно только за файлом\n" << std::endl;
+		return EXIT_FAILURE;
+	}
+
 	try
 	{
 		//
-		// Синхронизированный
+		// Клиент демона
 		//
-		if (verbose) std::wclog << L"Чтение \"" << sync_name.c_str() << L"\"" << std::endl;
-		std::wstring sync_content;
-		io::ReadFile(sync_name, sync_content);
-
-		if (verbose) std::wclog << L"Разбор скрипта" << std::endl;
-		format::srt::Phrases sync_phrases;
-		format::ass::Script sync_script;
-		PhrasesPtrVector sync_pPhrases;
-		format::Format sync_format = format::DetectFormat(sync_content);
-		switch (sync_format)
+		if ( !client_name.empty() )
 		{
-		case format::FMT_SRT:
-			if (verbose) std::wclog << L"Формат: SRT" << std::endl;
-			format::srt::Parse(sync_content, sync_phrases);
-			for (format::srt::Phrases::size_type i = 0; i < sync_phrases.size(); ++i)
+			if (verbose) std::wclog << L"Запрос к демону \"" << client_name.c_str() << L"\"" << std::endl;
+			if ( server::Request(client_name, sync_name, desync_name, out_name, params, engine_name) )
 			{
-				sync_pPhrases.push_back( &(sync_phrases[i]) );
+				if (verbose) std::wclog << L"Вывод \"" << out_name.c_str() << L"\"" << std::endl;
 			}
-			break;
-
-		case format::FMT_ASS:
-			if (verbose) std::wclog << L"Формат: SSA/ASS" << std::endl;
-			format::ass::Parse(sync_content, sync_script);
-			for (format::ass::Events::size_type i = 0; i < sync_script.meta_events.events.size(); ++i)
+			else
 			{
-				sync_pPhrases.push_back( &(sync_script.meta_events.events[i]) );
+				std::wclog << L"Субтитры синхронны" << std::endl;
 			}
-			break;
 
-		default:
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Format not supported"))
-				<< error_message(L"Формат не поддерживается")
-			);
+			std::wclog << L"Готово!" << std::endl;
+			return EXIT_SUCCESS;
+		}
+
+		//
+		// Применение карты сдвигов
+		//
+		if (apply)
+		{
+			if (verbose) std::wclog << L"Чтение карты сдвигов \"" << apply_shiftmap_name.c_str() << L"\"" << std::endl;
+			ShiftMap shift_map;
+			ReadShiftMap(apply_shiftmap_name, shift_map);
+
+			if (verbose) std::wclog << L"Сдвиг \"" << desync_name.c_str() << L"\" в \"" << out_name.c_str() << L"\"" << std::endl;
+			const size_t shifted = ApplyShiftMap(desync_name, out_name, shift_map);
+			if (verbose) std::wclog << L"Сдвинуто фраз: " << shifted << std::endl;
+
+			std::wclog << L"Готово!" << std::endl;
+			return EXIT_SUCCESS;
 		}
 
-		if (verbose) std::wclog << L"Группировка фраз" << std::endl;
-		PhraseGroups sync_groups;
-		GroupPhrases(sync_pPhrases, sync_groups);
-		if (sync_groups.size() < 1)
+		engine_options.verbose = verbose;
+		AlignmentEnginePtr engine = CreateEngine(engine_name, engine_options);
+
+		KeywordFilter user_keywords;
+		if ( !keywords_name.empty() )
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Phrase groups has not been formed"))
-				<< error_message(L"Не сформировано ни одной группы")
-			);
+			if (verbose) std::wclog << L"Чтение таблицы ключевых слов \"" << keywords_name.c_str() << L"\"" << std::endl;
+			user_keywords.Load(keywords_name);
 		}
+		const KeywordFilter& keywords = keywords_name.empty() ? DefaultKeywords() : user_keywords;
+		const unsigned long long keywords_hash = KeywordsHash(keywords_name);
 
 		//
-		// Рассинхронизированный
+		// Пакетный режим
 		//
-		if (verbose) std::wclog << L"Чтение \"" << desync_name.c_str() << L"\"" << std::endl;
-		std::wstring desync_content;
-		io::ReadFile(desync_name, desync_content);
-
-		if (verbose) std::wclog << L"Разбор скрипта" << std::endl;
-		format::srt::Phrases desync_phrases;
-		format::ass::Script desync_script;
-		PhrasesPtrVector desync_pPhrases;
-		format::Format desync_format = format::DetectFormat(desync_content);
-		switch (desync_format)
+		if ( !batch_name.empty() )
 		{
-		case format::FMT_SRT:
-			if (verbose) std::wclog << L"Формат: SRT" << std::endl;
-			format::srt::Parse(desync_content, desync_phrases);
-			for (format::srt::Phrases::size_type i = 0; i < desync_phrases.size(); ++i)
+			if (verbose) std::wclog << L"Чтение манифеста \"" << batch_name.c_str() << L"\"" << std::endl;
+			BatchJobs jobs;
+			ReadManifest(batch_name, jobs);
+
+			// Результат зависит и от таблицы ключевых слов
+			std::unique_ptr<ResultCache> cache;
+			if ( !cache_name.empty() )
 			{
-				desync_pPhrases.push_back( &(desync_phrases[i]) );
+				cache.reset( new ResultCache(cache_name, params, engine_name, engine_options, keywords_hash) );
 			}
-			break;
+			const size_t failed = RunBatch(jobs, keywords, keywords_hash, params, engine_name, engine_options, cache.get(), verbose);
+
+			std::wclog << L"Готово!" << std::endl;
+			return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		//
+		// Демон
+		//
+		if ( !serve_name.empty() )
+		{
+			server::Serve(serve_name, keywords, keywords_hash, params, engine_name, engine_options, verbose);
+
+			std::wclog << L"Готово!" << std::endl;
+			return EXIT_SUCCESS;
+		}
+
+		//
+		// Индекс синхронизированного скрипта
+		//
+		if ( !index_name.empty() )
+		{
+			if (verbose) std::wclog << L"Чтение \"" << sync_name.c_str() << L"\"" << std::endl;
+			std::wstring content;
+			unsigned long long source_size = 0, source_hash = 0;
+			io::ReadText(sync_name, content, &source_hash, &source_size);
+
+			if (verbose) std::wclog << L"Разбор скрипта" << std::endl;
+			SubtitleScript script(keywords);
+			script.Load(content);
+			if (verbose) PrintFormat(script.getFormat());
+
+			if (verbose) std::wclog << L"Группировка фраз" << std::endl;
+			PhraseGroups groups;
+			script.Group(params, groups);
+
+			if (verbose) std::wclog << L"Вывод индекса \"" << index_name.c_str() << L"\", групп: " << groups.size() << std::endl;
+			WriteReferenceIndex(index_name, groups, params, keywords_hash, source_size, source_hash);
 
-		case format::FMT_ASS:
-			if (verbose) std::wclog << L"Формат: SSA/ASS" << std::endl;
-			format::ass::Parse(desync_content, desync_script);
-			for (format::ass::Events::size_type i = 0; i < desync_script.meta_events.events.size(); ++i)
+			std::wclog << L"Готово!" << std::endl;
+			return EXIT_SUCCESS;
+		}
+
+		//
+		// Чтение, разбор и группировка обоих скриптов независимы и идут параллельно.
+		// При подборе параметров группировка откладывается до его окончания.
+		// Вместо синхронизированного скрипта может быть его индекс - тогда он уже сгруппирован.
+		//
+		if (verbose) std::wclog << L"Чтение и разбор \"" << sync_name.c_str() << L"\" и \"" << desync_name.c_str() << L"\"" << std::endl;
+		SubtitleScript sync_script(keywords), desync_script(keywords);
+		PhraseGroups sync_groups, desync_groups;
+		bool sync_indexed = false;
+		unsigned long long sync_hash = 0;
+		{
+			PhraseGroups* sync_target = nullptr;
+			PhraseGroups* desync_target = nullptr;
+			if (!auto_tune)
 			{
-				desync_pPhrases.push_back( &(desync_script.meta_events.events[i]) );
+				sync_target = &sync_groups;
+				desync_target = &desync_groups;
 			}
-			break;
 
-		default:
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Format not supported"))
-				<< error_message(L"Формат не поддерживается")
-			);
+			ThreadPool pool(2);
+			pool.Submit( boost::bind(&LoadReference, boost::cref(sync_name), &sync_script, boost::cref(params), keywords_hash, sync_target, &sync_indexed, &sync_hash) );
+			pool.Submit( boost::bind(&LoadScript, boost::cref(desync_name), &desync_script, boost::cref(params), desync_target, static_cast<unsigned long long*>(nullptr)) );
+			pool.Wait();
+		}
+		if (verbose)
+		{
+			if (sync_indexed)
+			{
+				std::wclog << L"Формат: индекс, групп: " << sync_groups.size() << std::endl;
+			}
+			else
+			{
+				PrintFormat(sync_script.getFormat());
+			}
+			PrintFormat(desync_script.getFormat());
 		}
 
-		if (verbose) std::wclog << L"Группировка фраз" << std::endl;
-		PhraseGroups desync_groups;
-		GroupPhrases(desync_pPhrases, desync_groups);
-		if (desync_groups.size() < 1)
+		//
+		// Подбор параметров
+		//
+		if (auto_tune)
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Phrase groups has not been formed"))
-				<< error_message(L"Не сформировано ни одной группы")
-			);
+			TuneResults tune_results;
+			size_t best = AutoTune(sync_script.getPhrases(), sync_script.getFilter(), desync_script.getPhrases(), desync_script.getFilter(),
+				params, engine_name, engine_options, tune_results);
+			PrintTuneResults(tune_results, best);
+			params = tune_results[best].params;
+
+			if (verbose) std::wclog << L"Группировка фраз" << std::endl;
+			sync_script.Group(params, sync_groups);
+			desync_script.Group(params, desync_groups);
 		}
 
 		format::svg::OutputFormats output_formats;
@@ -324,9 +509,43 @@ int main(int argc, char* argv[])
 			output_formats.push_back( format::svg::OutputFormat(desync_groups, std::wstring(L"Desynchronized"), std::wstring(L"#FFE69E")) );
 		}
 
-		if (verbose) std::wclog << L"Поиск точек рассинхронизации" << std::endl;
+		if (benchmark) BenchmarkEngines(sync_groups, desync_groups, params);
+
+		//
+		// Сопоставление; с состоянием прошлого запуска - только изменившихся участков
+		//
+		unsigned long long state_key = 0;
+		AlignmentState previous;
+		bool incremental = false;
+		if ( !state_name.empty() )
+		{
+			const std::string settings = ResultSettings(params, engine_name, engine_options, keywords_hash);
+			state_key = XXHash64(settings.data(), settings.size(), sync_hash);
+			incremental = previous.Load(state_name, state_key);
+			if (verbose && !incremental) std::wclog << L"Нет подходящего состояния \"" << state_name.c_str() << L"\"" << std::endl;
+		}
+
 		DesyncGroups desync_points;
-		GetLCS(sync_groups, desync_groups, desync_points);
+		SegmentShifts shifts;
+		size_t recomputed = 0;
+		if ( incremental && AlignIncremental(sync_groups, desync_groups, previous, params, desync_points, shifts, recomputed) )
+		{
+			if (verbose) std::wclog << L"Пересчитано точек рассинхронизации: " << recomputed << L" из " << desync_points.size() << std::endl;
+		}
+		else
+		{
+			if (verbose) std::wclog << L"Поиск точек рассинхронизации (" << engine->getName() << L")" << std::endl;
+			engine->Align(sync_groups, desync_groups, params, desync_points, shifts);
+		}
+
+		// Запоминается до сдвига групп
+		AlignmentState current(state_key, desync_groups, desync_points, shifts);
+		if ( !state_name.empty() )
+		{
+			if (verbose) std::wclog << L"Вывод состояния \"" << state_name.c_str() << L"\"" << std::endl;
+			current.Save(state_name);
+		}
+		if ( !emit_shiftmap_name.empty() ) EmitShiftMap(emit_shiftmap_name, desync_groups, desync_script.getPhrases(), shifts, verbose);
 		if (desync_points.size() < 1)
 		{
 			std::wclog << L"Субтитры синхронны" << std::endl;
@@ -350,11 +569,7 @@ int main(int argc, char* argv[])
 
 			if (verbose) std::wclog << L"Синхронизация" << std::endl;
 			PhraseGroups result;
-			Syncronize(sync_groups, desync_groups, desync_points, result);
-			for (PhraseGroups::iterator it = result.begin(); it != result.end(); ++it)
-			{
-				it->applyShift();
-			}
+			desync_script.Shift(desync_groups, shifts, result);
 
 			if (generate_svg)
 			{
@@ -362,25 +577,15 @@ int main(int argc, char* argv[])
 				output_formats.push_back( format::svg::OutputFormat(sync_desync_groups, std::wstring(L"Valid"), std::wstring(L"#66FF9B")) );
 				output_formats.push_back( format::svg::OutputFormat(desync_desync_groups, std::wstring(L"Invalid"), std::wstring(L"#FF7F7F")) );
 			}
+		}
 
+		// В конвейере синхронные субтитры тоже должны дойти до следующей команды.
+		// При слежении выход пишется всегда, как и в каждом цикле ниже.
+		if ( !out_name.empty() && (!desync_points.empty() || io::IsStandardStream(out_name) || watch) )
+		{
 			if (verbose) std::wclog << L"Генерация синхронизированного скрипта" << std::endl;
 			std::wstring out_content;
-			switch (desync_format)
-			{
-			case format::FMT_SRT:
-				format::srt::Generate(out_content, desync_phrases);
-				break;
-
-			case format::FMT_ASS:
-				format::ass::Generate(out_content, desync_script);
-				break;
-
-			default:
-				BOOST_THROW_EXCEPTION(
-					boost::enable_error_info(std::runtime_error("Format not supported"))
-					<< error_message(L"Формат не поддерживается")
-				);
-			}
+			desync_script.Generate(out_content);
 
 			if (verbose) std::wclog << L"Вывод \"" << out_name.c_str() << L"\"" << std::endl;
 			io::WriteFile(out_name, out_content);
@@ -396,6 +601,70 @@ int main(int argc, char* argv[])
 			io::WriteFile(svg_name, svg_content, false);
 		}
 
+		//
+		// Слежение за рассинхронизированным скриптом: синхронизированный, фильтр и алгоритм
+		// остаются в памяти, сопоставление пересчитывается только для изменившихся участков
+		//
+		if (watch)
+		{
+			typedef boost::chrono::steady_clock WatchClock;
+			FileWatcher watcher(desync_name);
+			std::wclog << L"Слежение за \"" << desync_name.c_str() << L"\", Ctrl+C - выход" << std::endl;
+
+			// Буферы переиспользуются между циклами
+			std::wstring content, out_content;
+			while ( watcher.Wait() )
+			{
+				WatchClock::time_point start = WatchClock::now();
+				try
+				{
+					io::ReadText(desync_name, content);
+					desync_script.Load(content);
+					desync_groups.clear();
+					desync_script.Group(params, desync_groups);
+
+					desync_points.clear();
+					shifts.clear();
+					if ( !AlignIncremental(sync_groups, desync_groups, current, params, desync_points, shifts, recomputed) )
+					{
+						engine->Align(sync_groups, desync_groups, params, desync_points, shifts);
+						recomputed = desync_points.size();
+					}
+					current = AlignmentState(state_key, desync_groups, desync_points, shifts);
+					if ( !state_name.empty() ) current.Save(state_name);
+					if ( !emit_shiftmap_name.empty() ) EmitShiftMap(emit_shiftmap_name, desync_groups, desync_script.getPhrases(), shifts, false);
+
+					if ( !desync_points.empty() )
+					{
+						PhraseGroups result;
+						desync_script.Shift(desync_groups, shifts, result);
+					}
+					// Выход пишется каждый цикл: если правка сделала субтитры синхронными,
+					// в нём должен оказаться исправленный скрипт, а не прошлый результат
+					out_content.clear();
+					desync_script.Generate(out_content);
+					io::WriteFile(out_name, out_content);
+
+					const double ms = boost::chrono::duration<double, boost::milli>(WatchClock::now() - start).count();
+					std::wclog << L"Цикл: " << ms << L" мс, точек рассинхронизации: " << desync_points.size()
+						<< L", пересчитано: " << recomputed << (desync_points.empty() ? L", субтитры синхронны" : L"") << std::endl;
+				}
+				catch (const std::exception& e)
+				{
+					// Недописанный при сохранении файл не должен прерывать слежение
+					std::wcerr << L"Ошибка: ";
+					if ( std::wstring const* info = boost::get_error_info<error_message>(e) )
+					{
+						std::wcerr << (*info) << std::endl;
+					}
+					else
+					{
+						std::wcerr << e.what() << std::endl;
+					}
+				}
+			}
+		}
+
 		std::wclog << L"Готово!" << std::endl;
 	}
 	catch (const std::exception& e)
@@ -420,6 +689,82 @@ int main(int argc, char* argv[])
 	return EXIT_SUCCESS;
 }
 
+// Чтение, разбор и, если groups != nullptr, группировка одного скрипта; hash - xxHash файла.
+// Выполняется в потоке пула, поэтому ничего не выводит.
+void LoadScript(const std::string& filename, SubtitleScript* script, const SyncParams& params, PhraseGroups* groups, unsigned long long* hash)
+{
+	std::wstring content;
+	io::ReadText(filename, content, hash);
+	script->Load(content);
+	if (groups != nullptr) script->Group(params, *groups);
+}
+
+// Синхронизированный скрипт или его индекс
+// hash индекса - хэш скрипта, по которому он построен
+void LoadReference(const std::string& filename, SubtitleScript* script, const SyncParams& params, unsigned long long keywords_hash,
+	PhraseGroups* groups, bool* indexed, unsigned long long* hash)
+{
+	*indexed = !io::IsStandardStream(filename) && IsReferenceIndex(filename);
+	if (!*indexed)
+	{
+		LoadScript(filename, script, params, groups, hash);
+		return;
+	}
+
+	// Фраз в индексе нет, подбирать параметры не по чему
+	if (groups == nullptr)
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Auto-tune requires a script, not an index"))
+			<< error_message(L"Для подбора параметров нужен скрипт, а не индекс")
+		);
+	}
+	ReferenceIndexHeader header;
+	LoadReferenceIndex(filename, params, keywords_hash, *groups, &header);
+	*hash = header.source_hash;
+}
+
+// Хэш таблицы ключевых слов, 0 - встроенная
+unsigned long long KeywordsHash(const std::string& keywords_name)
+{
+	if ( keywords_name.empty() ) return 0;
+	std::string data;
+	io::ReadData(keywords_name, data);
+	return XXHash64(data.data(), data.size());
+}
+
+// Карта сдвигов по участкам Syncronize, до SubtitleScript::Shift
+void EmitShiftMap(const std::string& filename, const PhraseGroups& desync_groups, const PhrasesPtrVector& phrases, const SegmentShifts& shifts, bool verbose)
+{
+	ShiftMap shift_map;
+	BuildShiftMap(desync_groups, phrases, shifts, shift_map);
+	if (verbose) std::wclog << L"Вывод карты сдвигов \"" << filename.c_str() << L"\", отрезков: " << shift_map.size() << std::endl;
+	// Фразы, пересекающиеся по времени с соседним участком, карта по одному началу не различит
+	const size_t mismatches = CheckShiftMap(desync_groups, phrases, shifts, shift_map);
+	if (mismatches > 0)
+	{
+		std::wclog << L"Внимание: с картой сдвигов время " << mismatches << L" фраз будет отличаться от вывода -o" << std::endl;
+	}
+	WriteShiftMap(filename, shift_map);
+}
+
+void PrintFormat(format::Format format)
+{
+	switch (format)
+	{
+	case format::FMT_SRT:
+		std::wclog << L"Формат: SRT" << std::endl;
+		break;
+
+	case format::FMT_ASS:
+		std::wclog << L"Формат: SSA/ASS" << std::endl;
+		break;
+
+	default:
+		break;
+	}
+}
+
 void PrintHelp(char exec_name[])
 {
 	std::wcout << L"Re_Sync: подгонка тайминга по подходящему варианту субтитров.\n"
@@ -427,12 +772,56 @@ void PrintHelp(char exec_name[])
 		L"Программа распространяется бесплатно на условиях лицензии GPLv3.\n"
 		L"\n"
 		L"Использование: " << exec_name << L" [ключи] -s <файл> -d <файл> -o <файл>\n"
+		L"               " << exec_name << L" [ключи] -s <файл> --write-index=<файл>\n"
+		L"               " << exec_name << L" [ключи] --batch=<файл>\n"
+		L"               " << exec_name << L" [ключи] --serve=<сокет>\n"
+		L"               " << exec_name << L" --apply-shiftmap=<файл> -d <файл> -o <файл>\n"
+		L"               " << exec_name << L" [ключи] --client=<сокет> -s <файл> -d <файл> -o <файл>\n"
 		L"Ключи:\n"
-		L"  -s, --sync=<файл>       Синхронизированный скрипт\n"
+		L"  -s, --sync=<файл>       Синхронизированный скрипт или его индекс\n"
 		L"  -d, --desync=<файл>     Рассинхронизированный скрипт\n"
 		L"  -o, --output=<файл>     Выходной скрипт\n"
+		L"                          Вместо любого из трёх файлов можно указать \"-\":\n"
+		L"                          скрипт читается из стандартного ввода или выводится\n"
+		L"                          в стандартный вывод. В стандартный вывод скрипт\n"
+		L"                          пишется, даже если субтитры уже синхронны.\n"
+		L"                          Скрипты, сжатые gzip или zstd, распаковываются при\n"
+		L"                          чтении, а выходной файл .gz или .zst сжимается.\n"
 		L"  -g, --graph=[файл]      Вывести внутреннее представление в виде графика\n"
 		L"                          в формате SVG. Имя файла по умолчанию - \"graph.svg\".\n"
+		L"  --write-index=<файл>    Сохранить группы синхронизированного скрипта в индекс.\n"
+		L"                          Индекс загружается без разбора, но только с теми же\n"
+		L"                          --min-duration, --max-offset, --skip-lyrics,\n"
+		L"                          --no-skip и --keywords.\n"
+		L"  --batch=<файл>          Пакетная синхронизация по манифесту: в каждой строке\n"
+		L"                          синхронизированный, рассинхронизированный и выходной\n"
+		L"                          скрипты через табуляцию. Задания выполняются\n"
+		L"                          параллельно, ошибка одного не прерывает остальные,\n"
+		L"                          но код возврата при ошибках ненулевой.\n"
+		L"  --state=<файл>          Сохранить группы, точки рассинхронизации и сдвиги,\n"
+		L"                          а при следующем запуске с тем же синхронизированным\n"
+		L"                          скриптом и ключами пересчитать только точки,\n"
+		L"                          группы которых изменились после правки.\n"
+		L"  --watch                 После синхронизации следить за рассинхронизированным\n"
+		L"                          скриптом и синхронизировать его заново после каждого\n"
+		L"                          сохранения, пересчитывая только изменившиеся участки.\n"
+		L"                          -o и --emit-shiftmap перезаписываются каждый раз.\n"
+		L"  --emit-shiftmap=<файл>  Сохранить сдвиги участков рассинхронизированного скрипта\n"
+		L"                          (отрезок времени и сдвиг в милисекундах). Без -o\n"
+		L"                          выходной скрипт не создаётся.\n"
+		L"  --apply-shiftmap=<файл> Сдвинуть -d по сохранённой карте в -o без сопоставления:\n"
+		L"                          файл читается построчно, меняются только времена фраз,\n"
+		L"                          поэтому одну карту можно применить к нескольким\n"
+		L"                          вариантам скрипта (надписи, полный, караоке).\n"
+		L"  --cache=<каталог>       Кэш результатов для --batch: задание с теми же\n"
+		L"                          скриптами и ключами берёт сдвиги из кэша без\n"
+		L"                          группировки и сопоставления.\n"
+		L"  --serve=<сокет>         Работать демоном на локальном сокете: фильтр,\n"
+		L"                          алгоритмы и группы последних синхронизированных\n"
+		L"                          скриптов остаются в памяти между запросами.\n"
+		L"                          Ключи задают параметры по умолчанию.\n"
+		L"  --client=<сокет>        Передать скрипты запущенному демону и записать\n"
+		L"                          результат. Ключи передаются вместе с запросом.\n"
 		L"\n"
 		L"  --min-duration=<число>  Минимальная продолжительность фразы. Более короткие\n"
 		L"                          фразы при синхронизации игнорируются.\n"
@@ -446,6 +835,21 @@ void PrintHelp(char exec_name[])
 		L"  --skip-lyrics           Пробовать пропускать открывающую и закрывающую песни\n"
 		L"  --no-skip               Не применять фильтры комментариев и песен\n"
 		L"  --allow-overlap         Разрешить перекрытие групп\n"
+		L"  --keywords=<файл>       Таблица ключевых слов фильтра комментариев и песен,\n"
+		L"                          построенная программой filtergen из списка слов\n"
+		L"  --engine=<название>     Алгоритм сопоставления групп. Доступные: auto, lcs, dtw,\n"
+		L"                          seed, anchors.\n"
+		L"                          auto выбирает точный lcs, если он укладывается в бюджет\n"
+		L"                          памяти, иначе самый быстрый из укладывающихся.\n"
+		L"                          По умолчанию auto.\n"
+		L"  --memory-budget=<число> Бюджет памяти для сопоставления групп, МБ.\n"
+		L"                          По умолчанию 1024 МБ.\n"
+		L"  --benchmark             Сравнить скорость и точность алгоритмов на входных\n"
+		L"                          скриптах перед синхронизацией\n"
+		L"  --auto-tune             Подобрать --min-duration, --max-offset, --max-desync\n"
+		L"                          и --max-shift: перебрать значения вдвое меньше и\n"
+		L"                          вдвое больше заданных, вывести таблицу и\n"
+		L"                          синхронизировать с лучшими\n"
 		L"\n"
 		L"  -v, --verbose           Выводить подробности\n"
 		L"  -h, --help              Вывести эту справку" << std::endl;
@@ -19,18 +19,16 @@
 
 #include <cstdlib>
 #include <algorithm>
+#include <memory>
 
-#if defined _MSC_VER && _MSC_VER >= 1600
-# include <regex>
-using std::wregex;
-namespace regex_constants = std::regex_constants;
-#else
-# include <boost/tr1/regex.hpp>
-using boost::wregex;
-namespace regex_constants = boost::regex_constants;
-#endif
+#include <boost/bind.hpp>
 
+#include "nullptr.h"
 #include "resync.h"
+#include "threadpool.h"
+
+// Число фраз, начиная с которого группировка идёт в нескольких потоках
+static const size_t PARALLEL_GROUPING_MIN = 1 << 15;
 
 
 bool PhrasePtrCmp (const Phrase* const first , const Phrase* const second)
@@ -45,112 +43,369 @@ bool PhrasePtrCmp (const Phrase* const first , const Phrase* const second)
 	}
 }
 
+/**********************************/
+/*   Сортировка фраз по времени   */
+/**********************************/
+struct PhraseSortKey
+{
+	unsigned long long key; // Начало в старших 32 битах, конец - в младших
+	Phrase* phrase;
+};
+
+// Устойчивая поразрядная сортировка по байтам ключа, начиная с младшего
+void RadixSortPhrases(PhrasesPtrVector& pPhrases)
+{
+	const size_t size = pPhrases.size();
+	std::vector<PhraseSortKey> keys(size), buffer(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		keys[i].key = (static_cast<unsigned long long>(pPhrases[i]->begin) << 32) | pPhrases[i]->end;
+		keys[i].phrase = pPhrases[i];
+	}
+
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[0x100] = {0};
+		for (size_t i = 0; i < size; ++i)
+		{
+			++counts[(keys[i].key >> shift) & 0xFF];
+		}
+
+		// Во всех ключах одинаковый байт (обычно старшие байты времени)
+		if (counts[(keys[0].key >> shift) & 0xFF] == size) continue;
+
+		size_t offset = 0;
+		for (size_t digit = 0; digit < 0x100; ++digit)
+		{
+			const size_t count = counts[digit];
+			counts[digit] = offset;
+			offset += count;
+		}
+		for (size_t i = 0; i < size; ++i)
+		{
+			buffer[counts[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+		}
+		keys.swap(buffer);
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		pPhrases[i] = keys[i].phrase;
+	}
+}
+
+void SortPhrases(PhrasesPtrVector& pPhrases)
+{
+	// Почти всегда фразы уже идут по порядку
+	for (size_t i = 1; i < pPhrases.size(); ++i)
+	{
+		if ( PhrasePtrCmp(pPhrases[i], pPhrases[i - 1]) )
+		{
+			RadixSortPhrases(pPhrases);
+			return;
+		}
+	}
+}
+
 /***************************************/
 /*   Фильтр фраз от авторов перевода   */
 /***************************************/
-inline bool IsCommentaryPhrase(const std::wstring& text)
+inline bool IsCommentaryPhrase(PhraseFilter& filter, const std::wstring& text, const SyncParams& params)
 {
-	if (NO_SKIP) return false;
+	if (params.no_skip) return false;
 
-	static bool ret;
+	return filter.IsCommentary(text, params.skip_lyrics);
+}
 
-	static wregex pattern(
-		L"(translat(ed?|or|ion)|(tim|typesett|encod|styl)(e[dr]|ing)|karaoke|note|QC|" // Английские
-		L"перевод|(тайм|стайл)инг|тайпсет|(е|э)нкод|(кодирован|оформлен)ие|редак(тор|тирование|тура|ция)|караоке|коммент|" // Русские
-		L"title|comment|sign|logo|insert|copyright|name|credit|" // Названия стилей
-		L"\\\\pos|^\\[(\\s|\\S)+\\]$)",
-		regex_constants::optimize | regex_constants::icase); // Комментарии
+// Короткие фразы и комментарии не участвуют в поиске групп
+inline bool IsDroppedPhrase(PhraseFilter& filter, const Phrase* phrase, const SyncParams& params)
+{
+	return static_cast<int>(phrase->end) - static_cast<int>(phrase->begin) < params.min_duration || IsCommentaryPhrase(filter, phrase->text, params);
+}
 
-	ret = regex_search(text, pattern, regex_constants::format_first_only);
+/***************************************************/
+/*   Параллельная группировка (префиксные суммы)   */
+/***************************************************/
+// Последовательный алгоритм проходит по фразам с состоянием (накопленные отброшенные фразы,
+// отступ первой из них, конец предыдущей фразы). Здесь то же решение выражено через
+// флаги и отступы, которые считаются независимо по участкам:
+//  - подходящая фраза начинает группу, если она первая подходящая или отступ больше MAX_OFFSET;
+//  - отброшенные фразы между двумя подходящими делятся на начало, которое уходит в группу
+//    предыдущей подходящей фразы, и конец, который уходит в группу следующей.
+// Поэтому каждая группа - непрерывный участок отсортированных фраз.
+class GroupingScan
+{
+public:
+	GroupingScan(PhrasesPtrVector& pPhrases, PhraseFilter& filter, const SyncParams& params, ThreadPool* pool);
+
+	// Флаги отброшенных фраз; false - нет ни одной подходящей фразы
+	bool Prepare();
+	void Run(PhraseGroups& groups);
+
+	size_t getCount() const { return _phrases.size(); }
+	size_t getFirstKept() const { return _first_kept; }
+	const Phrase* getPhrase(size_t r) const { return _phrases[r]; }
+	bool IsDropped(size_t r) const { return _drops[r] != 0; }
+	int Gap(size_t r) const;
+	// Первая фраза группы, которая начинается с подходящей фразы start (не первой)
+	size_t GroupFirst(size_t start) const;
+
+private:
+	typedef void (GroupingScan::*Pass)(size_t chunk);
+
+	void ForEachChunk(Pass pass);
+	void GetChunk(size_t size, size_t chunk, size_t& begin, size_t& end) const;
+	static void ExclusiveScan(std::vector<size_t>& counts);
+
+	void MarkDropped(size_t chunk);
+	void FindFirstKept(size_t chunk);
+	void CountStarts(size_t chunk);
+	void WriteStarts(size_t chunk);
+	void FindBounds(size_t chunk);
+
+	bool IsSplice(size_t r) const;
+
+	const PhrasesPtrVector& _phrases;
+	const SyncParams& _params;
+	ThreadPool* _pool;
+	size_t _chunks;
+	std::vector<PhraseFilter*> _filters;
+	std::vector<std::unique_ptr<PhraseFilter> > _clones;
+
+	std::vector<unsigned char> _drops, _is_start; // По фразам
+	std::vector<size_t> _counts;
+	size_t _first_kept;
+	std::vector<size_t> _starts; // Первые подходящие фразы групп
+	std::vector<size_t> _firsts, _lasts; // Первая фраза группы и последняя подходящая
+};
+
+GroupingScan::GroupingScan(PhrasesPtrVector& pPhrases, PhraseFilter& filter, const SyncParams& params, ThreadPool* pool)
+	: _phrases(pPhrases), _params(params), _pool(pool), _chunks(pool == nullptr ? 1 : pool->getSize() * 4), _first_kept(0)
+{
+	// Фильтры с кэшем нельзя использовать из нескольких потоков
+	_filters.push_back(&filter);
+	for (size_t chunk = 1; chunk < _chunks; ++chunk)
+	{
+		_clones.push_back( std::unique_ptr<PhraseFilter>(filter.Clone()) );
+		_filters.push_back( _clones.back().get() );
+	}
+}
 
-	if (SKIP_LYRICS && !ret)
+void GroupingScan::ForEachChunk(Pass pass)
+{
+	if (_pool == nullptr)
 	{
-		static wregex pattern_lyrics(L"(op|ed)[ _,-]|opening|ending", regex_constants::optimize | regex_constants::icase);
+		(this->*pass)(0);
+		return;
+	}
 
-		ret = regex_search(text, pattern_lyrics, regex_constants::format_first_only);
+	for (size_t chunk = 0; chunk < _chunks; ++chunk)
+	{
+		_pool->Submit( boost::bind(pass, this, chunk) );
 	}
+	_pool->Wait();
+}
 
-	return ret;
+void GroupingScan::GetChunk(size_t size, size_t chunk, size_t& begin, size_t& end) const
+{
+	begin = size * chunk / _chunks;
+	end = size * (chunk + 1) / _chunks;
 }
 
-/*********************************/
-/*   Объединение фраз в группы   */
-/*********************************/
-void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups)
+void GroupingScan::ExclusiveScan(std::vector<size_t>& counts)
 {
-	// Сортировка по времени
-	sort(pPhrases.begin(), pPhrases.end(), PhrasePtrCmp);
+	size_t sum = 0;
+	for (std::vector<size_t>::iterator it = counts.begin(); it != counts.end(); ++it)
+	{
+		const size_t count = *it;
+		*it = sum;
+		sum += count;
+	}
+}
+
+// Отступ от конца предыдущей фразы (у первой - от нуля)
+inline int GroupingScan::Gap(size_t r) const
+{
+	return static_cast<int>(_phrases[r]->begin) - (r == 0 ? 0 : static_cast<int>(_phrases[r - 1]->end));
+}
+
+// Фраза r забирает накопленные отброшенные фразы в текущую группу (последняя из них - r - 1)
+inline bool GroupingScan::IsSplice(size_t r) const
+{
+	if (r == 0) return false;
 
-	PhrasesPtrList pCurAccum, pDropAccum;
-	int firstDropOffset = 0, tempOffset;
-	unsigned int prevPhraseEnd = 0, curBegin = 0, curEnd = 0, curOffset = 0;
-	bool bNoGroups = true;
-	for (PhrasesPtrVector::iterator it = pPhrases.begin(); it != pPhrases.end(); ++it)
+	// Отступ последней отброшенной фразы; у фразы без предыдущего конца он нулевой
+	const int drop_offset = (r - 1 == 0 || _phrases[r - 2]->end == 0) ? 0 : Gap(r - 1);
+	return Gap(r) > drop_offset;
+}
+
+void GroupingScan::MarkDropped(size_t chunk)
+{
+	size_t begin, end;
+	GetChunk(_phrases.size(), chunk, begin, end);
+
+	PhraseFilter& filter = *_filters[chunk];
+	for (size_t i = begin; i < end; ++i)
 	{
-		// Уже есть отброшенные и новая фраза отстоит от предыдущей дальше первой
-		if ( !pDropAccum.empty() && static_cast<int>((*it)->begin) - static_cast<int>(prevPhraseEnd) > firstDropOffset && !bNoGroups )
+		const Phrase* phrase = _phrases[i];
+		const Phrase* prev = i > begin ? _phrases[i - 1] : nullptr;
+
+		// Тот же текст с тем же временем фильтровать повторно не нужно
+		if ( prev != nullptr && prev->begin == phrase->begin && prev->end == phrase->end && prev->text == phrase->text )
 		{
-			// Добавить в текущую группу
-			pCurAccum.splice(pCurAccum.end(), pDropAccum);
+			_drops[i] = _drops[i - 1];
 		}
-
-		// Отбрасываем короткие фразы или комментарии переводчиков
-		if ( static_cast<int>((*it)->end) - static_cast<int>((*it)->begin) < MIN_DURATION || IsCommentaryPhrase((*it)->text) )
+		else
 		{
-			// У первой фразы нет отступа
-			if ( prevPhraseEnd == 0 )
-			{
-				firstDropOffset = 0;
-			}
-			else
-			{
-				firstDropOffset = static_cast<int>((*it)->begin) - static_cast<int>(prevPhraseEnd);
-			}
-
-			pDropAccum.push_back(*it);
+			_drops[i] = IsDroppedPhrase(filter, phrase, _params);
 		}
-		else // Подходящая фраза
+	}
+}
+
+void GroupingScan::FindFirstKept(size_t chunk)
+{
+	size_t begin, end;
+	GetChunk(_phrases.size(), chunk, begin, end);
+
+	_counts[chunk] = _phrases.size();
+	for (size_t r = begin; r < end; ++r)
+	{
+		if ( !IsDropped(r) )
 		{
-			if ( static_cast<int>((*it)->begin) - static_cast<int>(prevPhraseEnd) > MAX_OFFSET || bNoGroups )
-			{
-				if (!bNoGroups)
-				{
-					groups.push_back( PhraseGroup(curBegin, curEnd, curOffset, pCurAccum) );
-					pCurAccum.clear();
-				}
+			_counts[chunk] = r;
+			break;
+		}
+	}
+}
 
-				// Новая группа
-				// Считаем отступы между началом групп
-				tempOffset = static_cast<int>((*it)->begin) - static_cast<int>(curBegin);
-				// Считаем отступы между группами
-				//tempOffset = static_cast<int>((*it)->begin) - static_cast<int>(curEnd);
-				curOffset = tempOffset < 0 ? 0u : static_cast<unsigned int>(tempOffset);
+void GroupingScan::CountStarts(size_t chunk)
+{
+	size_t begin, end;
+	GetChunk(_phrases.size(), chunk, begin, end);
 
-				curBegin = (*it)->begin;
+	size_t count = 0;
+	for (size_t r = begin; r < end; ++r)
+	{
+		_is_start[r] = !IsDropped(r) && (r == _first_kept || Gap(r) > _params.max_offset);
+		count += _is_start[r];
+	}
+	_counts[chunk] = count;
+}
 
-				bNoGroups = false;
-			}
-			
-			// Скинуть все накопленные, если есть
-			if ( !pDropAccum.empty() )
-			{
-				pCurAccum.splice(pCurAccum.end(), pDropAccum);
-			}
-			
-			curEnd = (*it)->end;
-			pCurAccum.push_back(*it);
-		}
-		
-		prevPhraseEnd = (*it)->end;
+void GroupingScan::WriteStarts(size_t chunk)
+{
+	size_t begin, end;
+	GetChunk(_phrases.size(), chunk, begin, end);
+
+	size_t pos = _counts[chunk];
+	for (size_t r = begin; r < end; ++r)
+	{
+		if (_is_start[r]) _starts[pos++] = r;
+	}
+}
+
+void GroupingScan::FindBounds(size_t chunk)
+{
+	size_t begin, end;
+	GetChunk(_starts.size(), chunk, begin, end);
+
+	for (size_t g = begin; g < end; ++g)
+	{
+		_firsts[g] = g == 0 ? 0 : GroupFirst(_starts[g]);
+
+		// Конец группы - конец последней подходящей фразы перед следующей группой
+		size_t last = g + 1 < _starts.size() ? _starts[g + 1] : _phrases.size();
+		do --last; while ( IsDropped(last) );
+		_lasts[g] = last;
 	}
-	// Скинуть оставшиеся
-	if ( !pDropAccum.empty() )
+}
+
+size_t GroupingScan::GroupFirst(size_t start) const
+{
+	// Отброшенные фразы перед группой уходят в предыдущую, начиная с последней,
+	// которую забрала бы какая-нибудь следующая фраза
+	size_t first = start;
+	bool splice = IsSplice(start);
+	for (size_t r = start; r > 0 && IsDropped(r - 1) && !splice; --r)
 	{
-		pCurAccum.splice(pCurAccum.end(), pDropAccum);
+		first = r - 1;
+		splice = IsSplice(r - 1);
 	}
-	if ( !pCurAccum.empty() && !bNoGroups )
+
+	return first;
+}
+
+bool GroupingScan::Prepare()
+{
+	const size_t size = _phrases.size();
+	if (size == 0) return false;
+
+	_drops.resize(size);
+	_counts.resize(_chunks);
+	ForEachChunk(&GroupingScan::MarkDropped);
+
+	ForEachChunk(&GroupingScan::FindFirstKept);
+	_first_kept = *std::min_element(_counts.begin(), _counts.end());
+
+	return _first_kept < _phrases.size();
+}
+
+void GroupingScan::Run(PhraseGroups& groups)
+{
+	if ( !Prepare() ) return;
+
+	const size_t size = _phrases.size();
+	size_t total;
+
+	_is_start.resize(_phrases.size());
+	ForEachChunk(&GroupingScan::CountStarts);
+	total = 0;
+	for (size_t chunk = 0; chunk < _chunks; ++chunk) total += _counts[chunk];
+	ExclusiveScan(_counts);
+	_starts.resize(total);
+	ForEachChunk(&GroupingScan::WriteStarts);
+
+	_firsts.resize(_starts.size());
+	_lasts.resize(_starts.size());
+	ForEachChunk(&GroupingScan::FindBounds);
+
+	// Группы ссылаются на общую копию отсортированных фраз
+	std::shared_ptr<PhrasesPtrVector> phrases(new PhrasesPtrVector(_phrases));
+	groups.reserve(groups.size() + _starts.size());
+	for (size_t g = 0; g < _starts.size(); ++g)
 	{
-		groups.push_back( PhraseGroup(curBegin, curEnd, curOffset, pCurAccum) );
+		const int offset = static_cast<int>(_phrases[_starts[g]]->begin) - (g == 0 ? 0 : static_cast<int>(_phrases[_starts[g - 1]]->begin));
+		const size_t first = _firsts[g];
+		const size_t last = g + 1 < _starts.size() ? _firsts[g + 1] : size;
+
+		groups.push_back( PhraseGroup(_phrases[_starts[g]]->begin, _phrases[_lasts[g]]->end, offset < 0 ? 0u : static_cast<unsigned int>(offset), phrases, first, last) );
+	}
+}
+
+/*********************************/
+/*   Объединение фраз в группы   */
+/*********************************/
+void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups, const SyncParams& params)
+{
+	PhraseFilter filter;
+	GroupPhrases(pPhrases, groups, filter, params);
+}
+
+void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups, PhraseFilter& filter, const SyncParams& params)
+{
+	// Сортировка по времени; фразы с одинаковым временем сохраняют исходный порядок
+	SortPhrases(pPhrases);
+
+	// Небольшие скрипты быстрее обработать в текущем потоке.
+	// При параллельном чтении обоих скриптов и в --batch группировка уже идёт на пуле.
+	if ( pPhrases.size() < PARALLEL_GROUPING_MIN || ThreadPool::InWorker() )
+	{
+		GroupingScan(pPhrases, filter, params, nullptr).Run(groups);
+	}
+	else
+	{
+		ThreadPool pool;
+		GroupingScan(pPhrases, filter, params, &pool).Run(groups);
 	}
 
 	// Отладка
@@ -158,8 +413,8 @@ void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups)
 	size_t debug_phrases_count = 0;
 	for (PhraseGroups::iterator it = groups.begin(); it != groups.end(); ++it)
 	{
-		std::wcout << L"Группа из " << it->_phrases.size() << std::endl;
-		debug_phrases_count += it->_phrases.size();
+		std::wcout << L"Группа из " << it->getPhraseCount() << std::endl;
+		debug_phrases_count += it->getPhraseCount();
 	}
 	std::wcout << L"Фраз в скрипте: " << pPhrases.size() << std::endl <<
 		L"Фраз в группах: " << debug_phrases_count << std::endl <<
@@ -167,86 +422,114 @@ void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups)
 	*/
 }
 
-#if 1
-/*********************************************************/
-/*   Нахождение наибольшей общей подпоследовательности   */
-/*********************************************************/
-void GetLCS(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& result)
+/******************************************************/
+/*   Группировка сразу для всех значений MAX_OFFSET   */
+/******************************************************/
+GroupingTree::GroupingTree(PhrasesPtrVector& pPhrases, PhraseFilter& filter, const SyncParams& params)
+	: _root(NO_NODE), _has_groups(false), _first_begin(0), _last_end(0)
 {
-	// Построение таблицы
-	std::vector< std::vector<unsigned int> > max_len(sync.size() + 1);
-	for (size_t i = 0; i <= sync.size(); ++i)
+	SortPhrases(pPhrases);
+	_phrases.reset( new PhrasesPtrVector(pPhrases) );
+
+	GroupingScan scan(pPhrases, filter, params, nullptr);
+	if ( !scan.Prepare() ) return;
+
+	// Узлы - подходящие фразы после первой: каждая из них начинает группу,
+	// если отступ от предыдущей фразы больше MAX_OFFSET
+	const size_t first_kept = scan.getFirstKept();
+	_first_begin = scan.getPhrase(first_kept)->begin;
+	unsigned int prev_end = scan.getPhrase(first_kept)->end;
+	for (size_t r = first_kept + 1; r < scan.getCount(); ++r)
 	{
-		max_len[i].resize(desync.size() + 1);
-		for (size_t j = 0; j <= desync.size(); ++j)
-		{
-			max_len[i][j] = 1;
-		}
+		if ( scan.IsDropped(r) ) continue;
+
+		Node node;
+		node.gap = scan.Gap(r);
+		node.begin = scan.getPhrase(r)->begin;
+		node.prev_end = prev_end;
+		node.first = scan.GroupFirst(r);
+		node.left = node.right = NO_NODE;
+		_nodes.push_back(node);
+
+		prev_end = scan.getPhrase(r)->end;
 	}
+	_last_end = prev_end;
 
-	// Заполнение таблицы
+	// Декартово дерево: по порядку узлов - время, по вложенности - убывание отступа
+	std::vector<size_t> stack;
+	for (size_t i = 0; i < _nodes.size(); ++i)
 	{
-		int i, j;
-		for (i = static_cast<int>(sync.size()) - 1; i >= 0; --i)
+		size_t last = NO_NODE;
+		while ( !stack.empty() && _nodes[stack.back()].gap < _nodes[i].gap )
 		{
-			for (j = static_cast<int>(desync.size()) - 1; j >= 0; --j)
-			{
-				if ( abs(static_cast<int>(sync[i].getOffset()) - static_cast<int>(desync[j].getOffset())) <= MAX_DESYNC )
-				{
-					max_len[i][j] = max_len[i+1][j+1] + 1;
-				}
-				else
-				{
-					max_len[i][j] = std::max(max_len[i+1][j], max_len[i][j+1]);
-				}
-			}
+			last = stack.back();
+			stack.pop_back();
 		}
+		_nodes[i].left = last;
+		if ( !stack.empty() ) _nodes[stack.back()].right = i;
+		stack.push_back(i);
 	}
+	_root = stack.empty() ? NO_NODE : stack.front();
+	_has_groups = true;
+}
 
-	// Нахождение наибольшей общей подпоследовательности
-	DesyncPositions syncAccum, desyncAccum;
-	size_t i = 0, j = 0;
-	while (max_len[i][j] != 0 && i < sync.size() && j < desync.size())
+void GroupingTree::GetGroups(int max_offset, PhraseGroups& groups) const
+{
+	if (!_has_groups) return;
+
+	unsigned int cur_begin = _first_begin, prev_begin = 0;
+	size_t cur_first = 0;
+
+	// Обход по порядку только узлов с отступом больше max_offset; поддеревья остальных пропускаются целиком
+	std::vector<size_t> stack;
+	size_t node = _root;
+	while ( node != NO_NODE || !stack.empty() )
 	{
-		if ( abs(static_cast<int>(sync[i].getOffset()) - static_cast<int>(desync[j].getOffset())) <= MAX_DESYNC )
+		while (node != NO_NODE && _nodes[node].gap > max_offset)
 		{
-			if (!syncAccum.empty() && !desyncAccum.empty())
-			{
-				result.push_back( DesyncGroup(syncAccum, desyncAccum) );
-			}
-			syncAccum.clear();
-			desyncAccum.clear();
-			++i;
-			++j;
-		}
-		else
-		{
-			if (max_len[i][j] == max_len[i+1][j])
-			{
-				syncAccum.push_back(i);
-				++i;
-			}
-			else
-			{
-				desyncAccum.push_back(j);
-				++j;
-			}
+			stack.push_back(node);
+			node = _nodes[node].left;
 		}
+		if ( stack.empty() ) break;
+
+		node = stack.back();
+		stack.pop_back();
+
+		const Node& start = _nodes[node];
+		const int offset = static_cast<int>(cur_begin) - static_cast<int>(prev_begin);
+		groups.push_back( PhraseGroup(cur_begin, start.prev_end, offset < 0 ? 0u : static_cast<unsigned int>(offset), _phrases, cur_first, start.first) );
+		prev_begin = cur_begin;
+		cur_begin = start.begin;
+		cur_first = start.first;
+
+		node = start.right;
 	}
+
+	const int offset = static_cast<int>(cur_begin) - static_cast<int>(prev_begin);
+	groups.push_back( PhraseGroup(cur_begin, _last_end, offset < 0 ? 0u : static_cast<unsigned int>(offset), _phrases, cur_first, _phrases->size()) );
+}
+
+/*********************************************************/
+/*   Нахождение наибольшей общей подпоследовательности   */
+/*********************************************************/
+void GetLCS(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& result)
+{
+	GetLCS(sync, 0, sync.size(), desync, 0, desync.size(), false, params, result);
 }
 
-#else
-/*******************************************************************************************/
-/*   Нахождение наибольшей общей подпоследовательности (обратный способ, устаревший код)   */
-/*******************************************************************************************/
-void GetLCS(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& result)
+// НОП на участке [sync_begin, sync_end) x [desync_begin, desync_end).
+// flush_tail - за участком следует совпадение, поэтому хвост тоже становится точкой рассинхронизации.
+void GetLCS(PhraseGroups& sync, size_t sync_begin, size_t sync_end, PhraseGroups& desync, size_t desync_begin, size_t desync_end, bool flush_tail,
+	const SyncParams& params, DesyncGroups& result)
 {
+	const size_t sync_size = sync_end - sync_begin, desync_size = desync_end - desync_begin;
+
 	// Построение таблицы
-	std::vector< std::vector<unsigned int> > max_len(desync.size() + 1);
-	for (size_t i = 0; i <= desync.size(); ++i)
+	std::vector< std::vector<unsigned int> > max_len(sync_size + 1);
+	for (size_t i = 0; i <= sync_size; ++i)
 	{
-		max_len[i].resize(sync.size() + 1);
-		for (size_t j = 0; j <= sync.size(); ++j)
+		max_len[i].resize(desync_size + 1);
+		for (size_t j = 0; j <= desync_size; ++j)
 		{
 			max_len[i][j] = 1;
 		}
@@ -255,11 +538,11 @@ void GetLCS(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& result)
 	// Заполнение таблицы
 	{
 		int i, j;
-		for (i = static_cast<int>(desync.size()) - 1; i >= 0; --i)
+		for (i = static_cast<int>(sync_size) - 1; i >= 0; --i)
 		{
-			for (j = static_cast<int>(sync.size()) - 1; j >= 0; --j)
+			for (j = static_cast<int>(desync_size) - 1; j >= 0; --j)
 			{
-				if ( abs(static_cast<int>(sync[j].getOffset()) - static_cast<int>(desync[i].getOffset())) <= MAX_DESYNC )
+				if ( abs(static_cast<int>(sync[sync_begin + i].getOffset()) - static_cast<int>(desync[desync_begin + j].getOffset())) <= params.max_desync )
 				{
 					max_len[i][j] = max_len[i+1][j+1] + 1;
 				}
@@ -274,9 +557,9 @@ void GetLCS(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& result)
 	// Нахождение наибольшей общей подпоследовательности
 	DesyncPositions syncAccum, desyncAccum;
 	size_t i = 0, j = 0;
-	while (max_len[i][j] != 0 && i < desync.size() && j < sync.size())
+	while (max_len[i][j] != 0 && i < sync_size && j < desync_size)
 	{
-		if ( abs(static_cast<int>(sync[j].getOffset()) - static_cast<int>(desync[i].getOffset())) <= MAX_DESYNC )
+		if ( abs(static_cast<int>(sync[sync_begin + i].getOffset()) - static_cast<int>(desync[desync_begin + j].getOffset())) <= params.max_desync )
 		{
 			if (!syncAccum.empty() && !desyncAccum.empty())
 			{
@@ -291,31 +574,44 @@ void GetLCS(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& result)
 		{
 			if (max_len[i][j] == max_len[i+1][j])
 			{
-				desyncAccum.push_back(i);
+				syncAccum.push_back(sync_begin + i);
 				++i;
 			}
 			else
 			{
-				syncAccum.push_back(j);
+				desyncAccum.push_back(desync_begin + j);
 				++j;
 			}
 		}
 	}
+
+	if (flush_tail)
+	{
+		for (; i < sync_size; ++i) syncAccum.push_back(sync_begin + i);
+		for (; j < desync_size; ++j) desyncAccum.push_back(desync_begin + j);
+		if (!syncAccum.empty() && !desyncAccum.empty())
+		{
+			result.push_back( DesyncGroup(syncAccum, desyncAccum) );
+		}
+	}
 }
-#endif
+
 
 /******************************************/
 /* Нахождение числа рассинхронизированных */
 /******************************************/
-unsigned int CountSyncronized(PhraseGroups& sync, PhraseGroups& desync)
+unsigned int CountSyncronized(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, unsigned long long* residual)
 {
 	unsigned int count = 0;
 	size_t i = 0, j = 0;
+	if (residual != nullptr) *residual = 0;
 	while (i < sync.size() && j < desync.size())
 	{
-		if ( abs(static_cast<int>(sync[i].getBegin()) - static_cast<int>(desync[j].getBegin())) <= MAX_DESYNC )
+		const int diff = abs(static_cast<int>(sync[i].getBegin()) - static_cast<int>(desync[j].getBegin()));
+		if (diff <= params.max_desync)
 		{
 			++count;
+			if (residual != nullptr) *residual += static_cast<unsigned int>(diff);
 			i++;
 			j++;
 		}
@@ -335,88 +631,107 @@ unsigned int CountSyncronized(PhraseGroups& sync, PhraseGroups& desync)
 /*********************/
 /*   Синхронизация   */
 /*********************/
-void Syncronize(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& desync_points, PhraseGroups& result)
+SegmentShift SyncronizePoint(PhraseGroups& sync, PhraseGroups& desync, const DesyncGroups& desync_points, size_t i,
+	unsigned int prev_end, const SyncParams& params)
 {
-	// Полная синхронизация
-	if (desync_points.size() < 1)
+	const DesyncPositions& sync_pos_i = desync_points[i].sync;
+	const DesyncPositions& desync_pos_i = desync_points[i].desync;
+
+	// Последняя группа или нет
+	size_t until_pos_sync, until_pos_desync;
+	if (i < desync_points.size() - 1)
 	{
-		return;
+		until_pos_sync = desync_points[i + 1].sync[0];
+		until_pos_desync = desync_points[i + 1].desync[0];
 	}
-	
-	size_t i, j, k;
-	// Первые синхронны
-	if (desync_points[0].desync[0] > 0)
+	else
 	{
-		for (i = 0; i < desync_points[0].desync[0]; ++i)
-		{
-			result.push_back(desync[i]);
-		}
+		until_pos_sync = sync.size();
+		until_pos_desync = desync.size();
 	}
 
-	size_t until_pos_sync, until_pos_desync, pos;
-	unsigned int sync_count, best_sync_count;
-	int shift, best_shift;
+	size_t j, k, pos;
+	unsigned int sync_count, best_sync_count = 0;
+	int shift, best_shift = 0;
 	PhraseGroups temp_sync, temp_desync;
-	unsigned int prev_end = 0;
-	for (i = 0; i < desync_points.size(); ++i)
+	for (j = 0; j < sync_pos_i.size(); ++j)
 	{
-		DesyncPositions& sync_pos_i = desync_points[i].sync;
-		DesyncPositions& desync_pos_i = desync_points[i].desync;
-		
-		// Последняя группа или нет
-		if (i < desync_points.size() - 1)
-		{
-			until_pos_sync = desync_points[i + 1].sync[0];
-			until_pos_desync = desync_points[i + 1].desync[0];
-		}
-		else
-		{
-			until_pos_sync = sync.size();
-			until_pos_desync = desync.size();
-		}
-		
-		best_sync_count = 0;
-		best_shift = 0;
-		for (j = 0; j < sync_pos_i.size(); ++j)
+		for (k = 0; k < desync_pos_i.size(); ++k)
 		{
-			for (k = 0; k < desync_pos_i.size(); ++k)
+			shift = static_cast<int>(sync[sync_pos_i[j]].getBegin()) - static_cast<int>(desync[desync_pos_i[k]].getBegin());
+			if (abs(shift) > params.max_shift) continue;
+
+			temp_desync.clear();
+			for (pos = desync_pos_i[0]; pos < until_pos_desync; ++pos)
 			{
-				shift = static_cast<int>(sync[sync_pos_i[j]].getBegin()) - static_cast<int>(desync[desync_pos_i[k]].getBegin());
-				if (abs(shift) > MAX_SHIFT) continue;
-				
-				temp_desync.clear();
-				for (pos = desync_pos_i[0]; pos < until_pos_desync; ++pos)
-				{
-					temp_desync.push_back( desync[pos] );
-					temp_desync.back().setShift(shift);
-				}
-				// Нельзя залазить на предыдущую группу
-				if (!ALLOW_OVERLAP && temp_desync.begin()->getBegin() < prev_end) continue;
+				temp_desync.push_back( desync[pos] );
+				temp_desync.back().setShift(shift);
+			}
+			// Нельзя залазить на предыдущую группу
+			if (!params.allow_overlap && temp_desync.begin()->getBegin() < prev_end) continue;
 
-				temp_sync.clear();
-				for (pos = sync_pos_i[0]; pos < until_pos_sync; ++pos)
-				{
-					temp_sync.push_back( sync[pos] );
-				}
-				
-				sync_count = CountSyncronized(temp_sync, temp_desync);
-				if (sync_count > best_sync_count)
-				{
-					best_sync_count = sync_count;
-					best_shift = shift;
-				}
+			temp_sync.clear();
+			for (pos = sync_pos_i[0]; pos < until_pos_sync; ++pos)
+			{
+				temp_sync.push_back( sync[pos] );
+			}
+
+			sync_count = CountSyncronized(temp_sync, temp_desync, params);
+			if (sync_count > best_sync_count)
+			{
+				best_sync_count = sync_count;
+				best_shift = shift;
 			}
 		}
+	}
+
+	return SegmentShift(desync_pos_i[0], until_pos_desync, best_shift);
+}
+
+unsigned int SegmentEnd(const PhraseGroups& desync, const SegmentShift& segment)
+{
+	PhraseGroup last = desync[segment.end - 1];
+	last.setShift(segment.shift);
+	return last.getEnd();
+}
+
+void Syncronize(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& desync_points, const SyncParams& params, SegmentShifts& shifts)
+{
+	// Полная синхронизация
+	if (desync_points.size() < 1)
+	{
+		return;
+	}
+
+	// Первые синхронны
+	if (desync_points[0].desync[0] > 0)
+	{
+		shifts.push_back( SegmentShift(0, desync_points[0].desync[0], 0) );
+	}
 
-		// Перекидываем лучший результат
-		for (pos = desync_pos_i[0]; pos < until_pos_desync; ++pos)
+	unsigned int prev_end = 0;
+	for (size_t i = 0; i < desync_points.size(); ++i)
+	{
+		// Запоминаем лучший результат
+		shifts.push_back( SyncronizePoint(sync, desync, desync_points, i, prev_end, params) );
+		prev_end = SegmentEnd(desync, shifts.back());
+	}
+}
+
+/************************************/
+/*   Применение сдвигов к группам   */
+/************************************/
+void ApplyShifts(PhraseGroups& desync, const SegmentShifts& shifts, PhraseGroups& result)
+{
+	for (SegmentShifts::const_iterator it = shifts.begin(); it != shifts.end(); ++it)
+	{
+		for (size_t pos = it->begin; pos < it->end; ++pos)
 		{
 			result.push_back( desync[pos] );
-			if (best_shift != 0)
+			if (it->shift != 0)
 			{
-				result.back().setShift(best_shift);
+				result.back().setShift(it->shift);
 			}
 		}
-		prev_end = result.back().getEnd();
 	}
 }
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
+#include "nullptr.h"
 #include "structure.h"
+#include "filter.h"
 
 
 /*****************************************************/
@@ -17,15 +19,82 @@ public:
 
 typedef std::vector<DesyncGroup> DesyncGroups;
 
+/**********************************************************/
+/*   Сдвиг участка групп рассинхронизированного скрипта   */
+/**********************************************************/
+class SegmentShift
+{
+public:
+	SegmentShift(size_t begin, size_t end, int shift) : begin(begin), end(end), shift(shift) {};
+	size_t begin, end; // Номера групп [begin, end)
+	int shift;
+};
+
+typedef std::vector<SegmentShift> SegmentShifts;
+
+/*******************************/
+/*   Параметры синхронизации   */
+/*******************************/
+// Передаются во все функции синхронизации вместо глобальных переменных,
+// поэтому несколько синхронизаций могут идти в разных потоках одновременно
+class SyncParams
+{
+public:
+	SyncParams() : min_duration(500), max_offset(5000), max_desync(200), max_shift(15000),
+		skip_lyrics(false), no_skip(false), allow_overlap(false) {};
+
+	int min_duration, max_offset, max_desync, max_shift; // В милисекундах
+	bool skip_lyrics; // Пропускать открывающую и закрывающую песни
+	bool no_skip; // Не применять фильтры комментариев и песен
+	bool allow_overlap; // Разрешить перекрытие групп
+};
 
-void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups);
-void GetLCS(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& result);
-void Syncronize(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& desync_points, PhraseGroups& result);
 
-extern int MIN_DURATION;
-extern int MAX_OFFSET;
-extern int MAX_DESYNC;
-extern int MAX_SHIFT;
-extern bool SKIP_LYRICS;
-extern bool NO_SKIP;
-extern bool ALLOW_OVERLAP;
+/******************************************************/
+/*   Группировка сразу для всех значений MAX_OFFSET   */
+/******************************************************/
+// Группы при большем MAX_OFFSET - объединения групп при меньшем, поэтому границы групп
+// хранятся в декартовом дереве по отступам. Построение - O(n log n) вместе с сортировкой,
+// группы для любого MAX_OFFSET - O(числа групп). Остальные параметры берутся при построении.
+class GroupingTree
+{
+public:
+	GroupingTree(PhrasesPtrVector& pPhrases, PhraseFilter& filter, const SyncParams& params);
+
+	void GetGroups(int max_offset, PhraseGroups& groups) const;
+
+private:
+	static const size_t NO_NODE = static_cast<size_t>(-1);
+
+	struct Node
+	{
+		int gap; // Отступ от предыдущей фразы
+		unsigned int begin, prev_end; // Начало фразы и конец предыдущей подходящей
+		size_t first; // Первая фраза группы, если группа начинается здесь
+		size_t left, right;
+	};
+
+	std::shared_ptr<PhrasesPtrVector> _phrases;
+	std::vector<Node> _nodes;
+	size_t _root;
+	bool _has_groups;
+	unsigned int _first_begin, _last_end;
+};
+
+// Сортировка по времени, как перед группировкой
+void SortPhrases(PhrasesPtrVector& pPhrases);
+void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups, const SyncParams& params);
+void GroupPhrases(PhrasesPtrVector& pPhrases, PhraseGroups& groups, PhraseFilter& filter, const SyncParams& params);
+void GetLCS(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, DesyncGroups& result);
+void GetLCS(PhraseGroups& sync, size_t sync_begin, size_t sync_end, PhraseGroups& desync, size_t desync_begin, size_t desync_end, bool flush_tail,
+	const SyncParams& params, DesyncGroups& result);
+// residual - сумма расхождений совпавших групп
+unsigned int CountSyncronized(PhraseGroups& sync, PhraseGroups& desync, const SyncParams& params, unsigned long long* residual = nullptr);
+void Syncronize(PhraseGroups& sync, PhraseGroups& desync, DesyncGroups& desync_points, const SyncParams& params, SegmentShifts& shifts);
+// Лучший сдвиг участка точки i - от её начала до следующей точки.
+// prev_end - конец предыдущего участка после сдвига, 0 для первой точки.
+SegmentShift SyncronizePoint(PhraseGroups& sync, PhraseGroups& desync, const DesyncGroups& desync_points, size_t i,
+	unsigned int prev_end, const SyncParams& params);
+// Конец участка после сдвига
+unsigned int SegmentEnd(const PhraseGroups& desync, const SegmentShift& segment);
+void ApplyShifts(PhraseGroups& desync, const SegmentShifts& shifts, PhraseGroups& result);
@@ -0,0 +1,115 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "exception.h"
+#include "script.h"
+
+
+SubtitleScript::SubtitleScript(const KeywordFilter& keywords)
+	: _keywords(keywords), _format(format::FMT_UNKNOWN), _filter(new PhraseFilter(keywords))
+{
+}
+
+/**************/
+/*   Разбор   */
+/**************/
+void SubtitleScript::Load(std::wstring& content)
+{
+	_srt_phrases.clear();
+	_ass_script = format::ass::Script();
+	_pPhrases.clear();
+
+	_format = format::DetectFormat(content);
+	switch (_format)
+	{
+	case format::FMT_SRT:
+		format::srt::Parse(content, _srt_phrases);
+		for (format::srt::Phrases::size_type i = 0; i < _srt_phrases.size(); ++i)
+		{
+			_pPhrases.push_back( &(_srt_phrases[i]) );
+		}
+		_filter.reset(new PhraseFilter(_keywords));
+		break;
+
+	case format::FMT_ASS:
+		format::ass::Parse(content, _ass_script);
+		for (format::ass::Events::size_type i = 0; i < _ass_script.meta_events.events.size(); ++i)
+		{
+			_pPhrases.push_back( &(_ass_script.meta_events.events[i]) );
+		}
+		_filter.reset(new AssEventFilter(_keywords));
+		break;
+
+	default:
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Format not supported"))
+			<< error_message(L"Формат не поддерживается")
+		);
+	}
+}
+
+/*****************/
+/*   Генерация   */
+/*****************/
+void SubtitleScript::Generate(std::wstring& content) const
+{
+	switch (_format)
+	{
+	case format::FMT_SRT:
+		format::srt::Generate(content, _srt_phrases);
+		break;
+
+	case format::FMT_ASS:
+		format::ass::Generate(content, _ass_script);
+		break;
+
+	default:
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Format not supported"))
+			<< error_message(L"Формат не поддерживается")
+		);
+	}
+}
+
+/*******************/
+/*   Группировка   */
+/*******************/
+void SubtitleScript::Group(const SyncParams& params, PhraseGroups& groups)
+{
+	GroupPhrases(_pPhrases, groups, *_filter, params);
+	if (groups.size() < 1)
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Phrase groups has not been formed"))
+			<< error_message(L"Не сформировано ни одной группы")
+		);
+	}
+}
+
+/**************************/
+/*   Применение сдвигов   */
+/**************************/
+void SubtitleScript::Shift(PhraseGroups& groups, const SegmentShifts& shifts, PhraseGroups& result)
+{
+	ApplyShifts(groups, shifts, result);
+	for (PhraseGroups::iterator it = result.begin(); it != result.end(); ++it)
+	{
+		it->applyShift();
+	}
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <string>
+#include <memory>
+
+#include "format.h"
+#include "structure.h"
+#include "filter.h"
+#include "resync.h"
+
+
+/*******************************************************/
+/*   Скрипт субтитров любого поддерживаемого формата   */
+/*******************************************************/
+// Фразы сортируются и сдвигаются на месте, а у фильтра есть кэш,
+// поэтому один скрипт нельзя использовать из нескольких потоков одновременно
+class SubtitleScript
+{
+public:
+	explicit SubtitleScript(const KeywordFilter& keywords = DefaultKeywords());
+
+	// Определение формата и разбор; content при разборе может измениться
+	void Load(std::wstring& content);
+	void Generate(std::wstring& content) const;
+
+	// Группировка фраз; исключение, если не сформировано ни одной группы
+	void Group(const SyncParams& params, PhraseGroups& groups);
+	// Сдвиг фраз по сдвигам участков групп; result - группы со сдвигами
+	void Shift(PhraseGroups& groups, const SegmentShifts& shifts, PhraseGroups& result);
+
+	format::Format getFormat() const { return _format; }
+	PhrasesPtrVector& getPhrases() { return _pPhrases; }
+	PhraseFilter& getFilter() { return *_filter; }
+
+private:
+	SubtitleScript(const SubtitleScript&);
+	SubtitleScript& operator=(const SubtitleScript&);
+
+	const KeywordFilter& _keywords;
+	format::Format _format;
+	format::srt::Phrases _srt_phrases;
+	format::ass::Script _ass_script;
+	PhrasesPtrVector _pPhrases;
+	std::unique_ptr<PhraseFilter> _filter;
+};
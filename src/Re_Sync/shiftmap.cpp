@@ -0,0 +1,364 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#if defined _MSC_VER && _MSC_VER >= 1400
+# ifndef _CRT_SECURE_NO_WARNINGS
+#  define _CRT_SECURE_NO_WARNINGS
+# endif
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+
+#include "nullptr.h"
+#include "exception.h"
+#include "format.h"
+#include "shiftmap.h"
+
+#ifdef __GNUC__
+# include "unix/io.h"
+#else
+# include "windows/io.h"
+#endif
+
+
+static const char SHIFTMAP_HEADER[] = "Re_Sync shift map 1";
+static const size_t STREAM_BUFFER = 64u * 1024u; // Строка длиннее переписывается только в начале
+
+static void ThrowShiftMapError(const char* what, const std::wstring& message)
+{
+	BOOST_THROW_EXCEPTION(
+		boost::enable_error_info(std::runtime_error(what))
+		<< error_message(message)
+	);
+}
+
+/******************/
+/*   Построение   */
+/******************/
+void BuildShiftMap(const PhraseGroups& desync, const PhrasesPtrVector& phrases, const SegmentShifts& shifts, ShiftMap& map)
+{
+	map.clear();
+	for (size_t i = 0; i < shifts.size(); ++i)
+	{
+		const SegmentShift& segment = shifts[i];
+		if (segment.begin >= segment.end) continue;
+
+		// Фразы отсортированы по началу, поэтому самая ранняя фраза участка - первая фраза
+		// его первой группы, а самая поздняя - последняя фраза последней группы
+		const PhraseGroup& first = desync[segment.begin];
+		const PhraseGroup& last = desync[segment.end - 1u];
+		if (first.getPhraseCount() < 1 || last.getPhraseCount() < 1) continue;
+
+		const unsigned int begin = phrases[first.getFirstPhrase()]->begin;
+		unsigned int end = phrases[last.getFirstPhrase() + last.getPhraseCount() - 1u]->begin + 1u;
+		// Фраза с тем же началом, что и у следующего участка, достаётся следующему
+		if (i + 1u < shifts.size() && shifts[i + 1u].begin < shifts[i + 1u].end)
+		{
+			const PhraseGroup& next = desync[shifts[i + 1u].begin];
+			if (next.getPhraseCount() > 0) end = std::min(end, phrases[next.getFirstPhrase()]->begin);
+		}
+
+		if (segment.shift == 0 || end <= begin) continue;
+		if (!map.empty() && map.back().end == begin && map.back().shift == segment.shift)
+		{
+			map.back().end = end;
+		}
+		else
+		{
+			map.push_back( ShiftRange(begin, end, segment.shift) );
+		}
+	}
+}
+
+static unsigned int ShiftTime(unsigned int time, int shift)
+{
+	// Как PhraseGroup::applyShift
+	const int temp = static_cast<int>(time) + shift;
+	return temp < 0 ? 0u : static_cast<unsigned int>(temp);
+}
+
+size_t CheckShiftMap(const PhraseGroups& desync, const PhrasesPtrVector& phrases, const SegmentShifts& shifts, const ShiftMap& map)
+{
+	// Сдвиг каждой фразы при обычной синхронизации: фразы вне групп не сдвигаются
+	std::vector<int> expected(phrases.size(), 0);
+	for (SegmentShifts::const_iterator it = shifts.begin(); it != shifts.end(); ++it)
+	{
+		for (size_t pos = it->begin; pos < it->end; ++pos)
+		{
+			const PhraseGroup& group = desync[pos];
+			for (size_t p = group.getFirstPhrase(); p < group.getFirstPhrase() + group.getPhraseCount(); ++p)
+			{
+				expected[p] = it->shift;
+			}
+		}
+	}
+
+	size_t mismatches = 0;
+	for (size_t p = 0; p < phrases.size(); ++p)
+	{
+		const Phrase& phrase = *phrases[p];
+		const int shift = FindShift(map, phrase.begin);
+		if ( ShiftTime(phrase.begin, shift) != ShiftTime(phrase.begin, expected[p]) ||
+			ShiftTime(phrase.end, shift) != ShiftTime(phrase.end, expected[p]) )
+		{
+			++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+static bool RangeBeginLess(unsigned int time, const ShiftRange& range)
+{
+	return time < range.begin;
+}
+
+int FindShift(const ShiftMap& map, unsigned int time)
+{
+	ShiftMap::const_iterator it = std::upper_bound(map.begin(), map.end(), time, RangeBeginLess);
+	if (it == map.begin()) return 0;
+	--it;
+	return time < it->end ? it->shift : 0;
+}
+
+/***********************/
+/*   Запись и чтение   */
+/***********************/
+void WriteShiftMap(const std::string& filename, const ShiftMap& map)
+{
+	std::ofstream fout(filename.c_str(), std::ios_base::binary);
+	fout.imbue(std::locale::classic());
+	if (!fout.is_open())
+	{
+		ThrowShiftMapError("Can't open file for writing", L"Ошибка открытия файла для записи");
+	}
+
+	fout << SHIFTMAP_HEADER << '\n';
+	for (ShiftMap::const_iterator it = map.begin(); it != map.end(); ++it)
+	{
+		fout << it->begin << ' ' << it->end << ' ' << it->shift << '\n';
+	}
+	fout.close();
+	if (!fout)
+	{
+		ThrowShiftMapError("Shift map write error", L"Ошибка записи карты сдвигов");
+	}
+}
+
+void ReadShiftMap(const std::string& filename, ShiftMap& map)
+{
+	std::ifstream fin(filename.c_str(), std::ios_base::binary);
+	fin.imbue(std::locale::classic());
+	if (!fin.is_open())
+	{
+		ThrowShiftMapError("Can't open file", L"Ошибка открытия файла");
+	}
+
+	std::string line;
+	if ( !std::getline(fin, line) || line.compare(0, sizeof(SHIFTMAP_HEADER) - 1u, SHIFTMAP_HEADER) != 0 )
+	{
+		ThrowShiftMapError("Not a shift map", L"Файл не является картой сдвигов");
+	}
+
+	map.clear();
+	while ( std::getline(fin, line) )
+	{
+		if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+		std::istringstream iss(line);
+		iss.imbue(std::locale::classic());
+		unsigned int begin = 0, end = 0;
+		int shift = 0;
+		// Отрезки идут по времени и не перекрываются, иначе FindShift не найдёт нужный
+		if ( !(iss >> begin >> end >> shift) || begin >= end || (!map.empty() && begin < map.back().end) )
+		{
+			ThrowShiftMapError("Corrupted shift map", L"Повреждённая карта сдвигов");
+		}
+		map.push_back( ShiftRange(begin, end, shift) );
+	}
+}
+
+/***********************/
+/*   Потоковый сдвиг   */
+/***********************/
+namespace
+{
+	// Ровно count цифр
+	bool ParseNumber(const char*& pos, const char* end, size_t count, unsigned int& value)
+	{
+		value = 0;
+		for (size_t i = 0; i < count; ++i, ++pos)
+		{
+			if (pos == end || *pos < '0' || *pos > '9') return false;
+			value = value * 10u + static_cast<unsigned int>(*pos - '0');
+		}
+		return true;
+	}
+
+	// Как timestamp в грамматиках format: SRT - HH:MM:SS,mmm, ASS - H:MM:SS.cc
+	bool ParseTime(const char*& pos, const char* end, format::Format fmt, unsigned int& time)
+	{
+		const bool ass = fmt == format::FMT_ASS;
+		unsigned int h, m, s, f;
+		if ( !ParseNumber(pos, end, ass ? 1u : 2u, h) || pos == end || *pos++ != ':' ) return false;
+		if ( !ParseNumber(pos, end, 2u, m) || pos == end || *pos++ != ':' ) return false;
+		if ( !ParseNumber(pos, end, 2u, s) || pos == end || *pos++ != (ass ? '.' : ',') ) return false;
+		if ( !ParseNumber(pos, end, ass ? 2u : 3u, f) ) return false;
+		time = ((h * 60u + m) * 60u + s) * 1000u + (ass ? f * 10u : f);
+		return true;
+	}
+
+	// Как генераторы format
+	size_t FormatTime(char* buf, unsigned int time, format::Format fmt)
+	{
+		const unsigned int h = time / 3600000u, m = (time % 3600000u) / 60000u, s = (time % 60000u) / 1000u;
+		const int size = fmt == format::FMT_ASS
+			? sprintf(buf, "%u:%02u:%02u.%02u", h, m, s, (time % 1000u) / 10u)
+			: sprintf(buf, "%02u:%02u:%02u,%03u", h, m, s, time % 1000u);
+		return static_cast<size_t>(size);
+	}
+
+	const char* SkipBlanks(const char* pos, const char* end)
+	{
+		while (pos != end && (*pos == ' ' || *pos == '\t')) ++pos;
+		return pos;
+	}
+
+	bool StartsWith(const char* pos, const char* end, const char* prefix)
+	{
+		const size_t size = strlen(prefix);
+		return static_cast<size_t>(end - pos) >= size && memcmp(pos, prefix, size) == 0;
+	}
+
+	// Положения начала и конца фразы в строке. fmt уточняется по первой строке,
+	// по которой формат понятен, как в format::DetectFormat.
+	bool FindTimes(const char* line, const char* end, format::Format& fmt, const char* (&spans)[4], unsigned int (&times)[2])
+	{
+		const char* pos = SkipBlanks(line, end);
+		if (fmt == format::FMT_UNKNOWN && StartsWith(pos, end, "[Events]"))
+		{
+			fmt = format::FMT_ASS;
+			return false;
+		}
+
+		if (fmt == format::FMT_ASS)
+		{
+			// Dialogue: слой, начало, конец, ...
+			if ( !StartsWith(pos, end, "Dialogue:") ) return false;
+			pos = static_cast<const char*>( memchr(pos, ',', end - pos) );
+			if (pos == nullptr) return false;
+			for (int i = 0; i < 2; ++i)
+			{
+				pos = SkipBlanks(pos + 1, end);
+				spans[i * 2] = pos;
+				if ( !ParseTime(pos, end, fmt, times[i]) ) return false;
+				spans[i * 2 + 1] = pos;
+				pos = SkipBlanks(pos, end);
+				if (pos == end || *pos != ',') return false;
+			}
+			return true;
+		}
+
+		// Строка времени SRT: начало --> конец
+		const format::Format srt = format::FMT_SRT;
+		if (fmt != format::FMT_UNKNOWN && fmt != srt) return false;
+		spans[0] = pos;
+		if ( !ParseTime(pos, end, srt, times[0]) ) return false;
+		spans[1] = pos;
+		pos = SkipBlanks(pos, end);
+		if ( !StartsWith(pos, end, "-->") ) return false;
+		pos = SkipBlanks(pos + 3, end);
+		spans[2] = pos;
+		if ( !ParseTime(pos, end, srt, times[1]) ) return false;
+		spans[3] = pos;
+		fmt = srt;
+		return true;
+	}
+}
+
+size_t ApplyShiftMap(const std::string& in_name, const std::string& out_name, const ShiftMap& map)
+{
+	io::InputStream fin(in_name);
+	io::OutputStream fout(out_name);
+
+	format::Format fmt = format::FMT_UNKNOWN;
+	size_t shifted = 0;
+	std::vector<char> buffer(STREAM_BUFFER);
+	char* const data = &buffer[0];
+	size_t begin = 0, end = 0; // Непрочитанное в буфере
+	bool eof = false, first = true;
+	bool tail = false; // Продолжение строки, не поместившейся в буфер, копируется как есть
+	for (;;)
+	{
+		const char* line = data + begin;
+		const char* nl = static_cast<const char*>( memchr(line, '\n', end - begin) );
+		if (nl == nullptr && !eof && (begin > 0 || end < buffer.size()))
+		{
+			// Дочитываем, сдвинув остаток строки в начало буфера
+			memmove(data, line, end - begin);
+			end -= begin;
+			begin = 0;
+			const size_t count = fin.Read(data + end, buffer.size() - end);
+			end += count;
+			eof = count == 0;
+			continue;
+		}
+
+		const size_t length = nl != nullptr ? nl - line + 1 : end - begin;
+		if (length == 0) break;
+
+		const char* from = line;
+		const char* const line_end = line + length;
+		if (first && StartsWith(line, line_end, "\xEF\xBB\xBF")) from += 3;
+		first = false;
+
+		const char* spans[4];
+		unsigned int times[2];
+		if ( !tail && FindTimes(from, line_end, fmt, spans, times) )
+		{
+			const int shift = FindShift(map, times[0]);
+			char buf[32];
+			fout.Write(line, spans[0] - line);
+			fout.Write(buf, FormatTime(buf, ShiftTime(times[0], shift), fmt));
+			fout.Write(spans[1], spans[2] - spans[1]);
+			fout.Write(buf, FormatTime(buf, ShiftTime(times[1], shift), fmt));
+			fout.Write(spans[3], line_end - spans[3]);
+			if (shift != 0) ++shifted;
+		}
+		else
+		{
+			fout.Write(line, length);
+		}
+
+		tail = nl == nullptr;
+		begin += length;
+	}
+
+	// До Close, чтобы переписанный без изменений файл не остался выходом
+	if (fmt == format::FMT_UNKNOWN)
+	{
+		ThrowShiftMapError("Unknown format", L"Формат не поддерживается");
+	}
+	fout.Close();
+	return shifted;
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+#include "structure.h"
+#include "resync.h"
+
+
+/****************************************************/
+/*   Сдвиг отрезка рассинхронизированного скрипта   */
+/****************************************************/
+class ShiftRange
+{
+public:
+	ShiftRange(unsigned int begin, unsigned int end, int shift) : begin(begin), end(end), shift(shift) {};
+	unsigned int begin, end; // Время до сдвига [begin, end), мс
+	int shift;
+};
+typedef std::vector<ShiftRange> ShiftMap;
+
+// По участкам Syncronize, до SubtitleScript::Shift. Отрезок участка - от начала самой ранней
+// до начала самой поздней фразы его групп; отрезки без сдвига не хранятся.
+void BuildShiftMap(const PhraseGroups& desync, const PhrasesPtrVector& phrases, const SegmentShifts& shifts, ShiftMap& map);
+// Число фраз, которые по карте получат другие времена, чем при SubtitleScript::Shift
+size_t CheckShiftMap(const PhraseGroups& desync, const PhrasesPtrVector& phrases, const SegmentShifts& shifts, const ShiftMap& map);
+// Сдвиг фразы по времени её начала, 0 - вне отрезков
+int FindShift(const ShiftMap& map, unsigned int time);
+
+// Текстовый файл: строка заголовка, затем по строке "начало конец сдвиг" в милисекундах
+void WriteShiftMap(const std::string& filename, const ShiftMap& map);
+void ReadShiftMap(const std::string& filename, ShiftMap& map);
+
+// Скрипт SRT или ASS читается построчно буфером постоянного размера и переписываются только
+// времена фраз: ни фраз, ни скрипта в памяти не строится, остальные байты, включая кодировку,
+// не меняются. Имя "-" - стандартный ввод или вывод. Возвращает число сдвинутых фраз.
+size_t ApplyShiftMap(const std::string& in_name, const std::string& out_name, const ShiftMap& map);
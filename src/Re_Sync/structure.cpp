@@ -20,21 +20,21 @@
 #include "structure.h"
 
 
-unsigned int PhraseGroup::getBegin()
+unsigned int PhraseGroup::getBegin() const
 {
 	int ret = static_cast<int>(_begin) + _shift;
 	if (ret < 0) ret = 0;
 	return static_cast<unsigned int>(ret);
 }
 	
-unsigned int PhraseGroup::getEnd()
+unsigned int PhraseGroup::getEnd() const
 {
 	int ret = static_cast<int>(_end) + _shift;
 	if (ret < 0) ret = 0;
 	return static_cast<unsigned int>(ret);
 }
 
-unsigned int PhraseGroup::getOffset()
+unsigned int PhraseGroup::getOffset() const
 {
 	return _offset;
 }
@@ -49,7 +49,7 @@ void PhraseGroup::applyShift()
 	int temp;
 	Phrase* pPhrase;
 
-	for (PhrasesPtrList::iterator it = _phrases.begin(); it != _phrases.end(); ++it)
+	for (PhrasesPtrVector::const_iterator it = _phrases->begin() + _first; it != _phrases->begin() + _last; ++it)
 	{
 		pPhrase = (*it);
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <memory>
 
 #include <boost/optional.hpp>
 #include <boost/fusion/adapted/struct/detail/extension.hpp>
@@ -17,7 +18,6 @@ struct Phrase
 	std::wstring text;
 };
 typedef std::vector<Phrase*> PhrasesPtrVector;
-typedef std::list<Phrase*> PhrasesPtrList;
 
 namespace format
 {
@@ -73,17 +73,21 @@ class PhraseGroup
 {
 	unsigned int _begin, _end, _offset;
 	int _shift;
-	PhrasesPtrList _phrases;
+	std::shared_ptr<PhrasesPtrVector> _phrases; // Фразы скрипта по времени, общие для всех групп
+	size_t _first, _last; // Фразы группы [_first, _last)
 
 public:
-	PhraseGroup(unsigned int begin, unsigned int end, unsigned int offset, PhrasesPtrList& phrases)
-		: _begin(begin), _end(end), _offset(offset), _shift(0), _phrases(phrases) {};
+	PhraseGroup(unsigned int begin, unsigned int end, unsigned int offset, const std::shared_ptr<PhrasesPtrVector>& phrases, size_t first, size_t last)
+		: _begin(begin), _end(end), _offset(offset), _shift(0), _phrases(phrases), _first(first), _last(last) {};
 
-	unsigned int getBegin();
-	unsigned int getEnd();
-	unsigned int getOffset();
+	unsigned int getBegin() const;
+	unsigned int getEnd() const;
+	unsigned int getOffset() const;
 	void setShift(int shift);
 	void applyShift();
+	int getShift() const { return _shift; }
+	size_t getFirstPhrase() const { return _first; }
+	size_t getPhraseCount() const { return _last - _first; }
 };
 
 typedef std::vector<PhraseGroup> PhraseGroups;
@@ -0,0 +1,184 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "nullptr.h"
+#include "threadpool.h"
+
+
+// Поток принадлежит какому-либо пулу
+static boost::thread_specific_ptr<bool> any_worker;
+
+ThreadPool::ThreadPool(size_t threads) : _queued(0), _pending(0), _next(0), _stolen(0), _stop(false)
+{
+	if (threads == 0)
+	{
+		threads = boost::thread::hardware_concurrency();
+		if (threads == 0) threads = 1;
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		_queues.push_back( std::unique_ptr<Queue>(new Queue) );
+	}
+	for (size_t i = 0; i < threads; ++i)
+	{
+		_threads.create_thread(boost::bind(&ThreadPool::Worker, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_task_ready.notify_all();
+	_threads.join_all();
+}
+
+void ThreadPool::Submit(const Task& task)
+{
+	size_t index;
+	if (_worker.get() != nullptr)
+	{
+		index = *_worker;
+	}
+	else
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		index = _next++ % _queues.size();
+	}
+
+	{
+		boost::lock_guard<boost::mutex> lock(_queues[index]->mutex);
+		_queues[index]->tasks.push_back(task);
+	}
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		++_queued;
+		++_pending;
+	}
+	_task_ready.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	boost::exception_ptr error;
+	{
+		boost::unique_lock<boost::mutex> lock(_mutex);
+		while (_pending > 0)
+		{
+			_all_done.wait(lock);
+		}
+		error = _error;
+		_error = boost::exception_ptr();
+	}
+
+	if (error)
+	{
+		boost::rethrow_exception(error);
+	}
+}
+
+unsigned long long ThreadPool::getStolen()
+{
+	boost::lock_guard<boost::mutex> lock(_mutex);
+	return _stolen;
+}
+
+/**************************************/
+/*   Своя задача или краденая чужая   */
+/**************************************/
+bool ThreadPool::Take(size_t index, Task& task)
+{
+	// Задача обязательно найдётся: в очередях их не меньше, чем закреплено за потоками.
+	// Проход может разминуться с ней, только если её положили в уже проверенную очередь.
+	for (;;)
+	{
+		{
+			Queue& own = *_queues[index];
+			boost::lock_guard<boost::mutex> lock(own.mutex);
+			if ( !own.tasks.empty() )
+			{
+				task = own.tasks.back();
+				own.tasks.pop_back();
+				return false;
+			}
+		}
+
+		for (size_t k = 1; k < _queues.size(); ++k)
+		{
+			Queue& victim = *_queues[(index + k) % _queues.size()];
+			boost::lock_guard<boost::mutex> lock(victim.mutex);
+			if ( !victim.tasks.empty() )
+			{
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+	}
+}
+
+bool ThreadPool::InWorker()
+{
+	return any_worker.get() != nullptr;
+}
+
+/****************************/
+/*   Цикл рабочего потока   */
+/****************************/
+void ThreadPool::Worker(size_t index)
+{
+	_worker.reset(new size_t(index));
+	any_worker.reset(new bool(true));
+
+	for (;;)
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(_mutex);
+			while (_queued == 0 && !_stop)
+			{
+				_task_ready.wait(lock);
+			}
+			if (_queued == 0) return;
+
+			// Одна из задач в очередях закреплена за этим потоком
+			--_queued;
+		}
+
+		Task task;
+		bool stolen = Take(index, task);
+
+		boost::exception_ptr error;
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			error = boost::current_exception();
+		}
+
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		if (stolen) ++_stolen;
+		if (error && !_error) _error = error;
+		if (--_pending == 0) _all_done.notify_all();
+	}
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/exception_ptr.hpp>
+
+
+/**********************************/
+/*   Пул потоков с кражей задач   */
+/**********************************/
+// У каждого потока своя очередь: задачи из потока пула попадают в его очередь,
+// остальные раскладываются по очередям по кругу. Поток берёт задачи с конца своей очереди,
+// а когда она пуста - крадёт с начала чужих, поэтому неравные задачи не простаивают за одной.
+class ThreadPool
+{
+public:
+	typedef boost::function<void()> Task;
+
+	// 0 - по числу аппаратных потоков
+	explicit ThreadPool(size_t threads = 0);
+	~ThreadPool();
+
+	void Submit(const Task& task);
+	// Ожидание всех отправленных задач; первое исключение из задач пробрасывается дальше
+	void Wait();
+
+	size_t getSize() const { return _queues.size(); }
+	// Текущий поток - рабочий какого-либо пула. Вложенный пул на нём
+	// только умножил бы потоки сверх числа ядер.
+	static bool InWorker();
+	// Сколько задач выполнено не тем потоком, в чью очередь они попали
+	unsigned long long getStolen();
+
+private:
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	struct Queue
+	{
+		std::deque<Task> tasks;
+		boost::mutex mutex;
+	};
+
+	void Worker(size_t index);
+	// true - задача украдена из чужой очереди
+	bool Take(size_t index, Task& task);
+
+	boost::thread_group _threads;
+	std::vector< std::unique_ptr<Queue> > _queues;
+	boost::thread_specific_ptr<size_t> _worker; // Очередь текущего потока, если он из пула
+	boost::mutex _mutex;
+	boost::condition_variable _task_ready, _all_done;
+	size_t _queued, _pending, _next; // _queued - в очередях и ещё не закреплены за потоком
+	unsigned long long _stolen;
+	bool _stop;
+	boost::exception_ptr _error;
+};
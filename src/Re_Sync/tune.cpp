@@ -0,0 +1,256 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+
+#include <boost/chrono.hpp>
+#include <boost/bind.hpp>
+
+#include "exception.h"
+#include "tune.h"
+#include "threadpool.h"
+
+
+// Множители параметров относительно заданных. Первый - сами заданные,
+// поэтому при равной оценке они и остаются.
+static const double TUNE_FACTORS[] = {1.0, 0.5, 2.0};
+static const size_t TUNE_FACTOR_COUNT = sizeof(TUNE_FACTORS) / sizeof(TUNE_FACTORS[0]);
+
+// Значения параметра по сетке без повторов
+static void TuneValues(int base, std::vector<int>& values)
+{
+	for (size_t k = 0; k < TUNE_FACTOR_COUNT; ++k)
+	{
+		int value = static_cast<int>(base * TUNE_FACTORS[k]);
+		if (std::find(values.begin(), values.end(), value) == values.end()) values.push_back(value);
+	}
+}
+
+/******************************************/
+/*   Перебор параметров на пуле потоков   */
+/******************************************/
+// Скрипты разбираются один раз. Для каждого значения MIN_DURATION строится GroupingTree,
+// из которого группы при любом MAX_OFFSET получаются без повторной группировки.
+class Tuner
+{
+public:
+	Tuner(PhrasesPtrVector& sync, PhraseFilter& sync_filter, PhrasesPtrVector& desync, PhraseFilter& desync_filter,
+		const SyncParams& base, const std::string& engine_name, const EngineOptions& engine_options);
+
+	size_t Run(TuneResults& results);
+
+private:
+	void BuildTrees(size_t k);
+	void Evaluate(size_t k, TuneResult* result);
+
+	PhrasesPtrVector& _sync;
+	PhraseFilter& _sync_filter;
+	PhrasesPtrVector& _desync;
+	PhraseFilter& _desync_filter;
+	const SyncParams& _base;
+	const std::string& _engine_name;
+	EngineOptions _engine_options;
+
+	std::vector<int> _min_durations;
+	std::vector< std::unique_ptr<GroupingTree> > _sync_trees, _desync_trees; // По значениям MIN_DURATION
+	PhraseGroups _sync_eval, _desync_eval; // Оценочное разбиение при заданных параметрах
+};
+
+Tuner::Tuner(PhrasesPtrVector& sync, PhraseFilter& sync_filter, PhrasesPtrVector& desync, PhraseFilter& desync_filter,
+	const SyncParams& base, const std::string& engine_name, const EngineOptions& engine_options)
+	: _sync(sync), _sync_filter(sync_filter), _desync(desync), _desync_filter(desync_filter),
+	_base(base), _engine_name(engine_name), _engine_options(engine_options)
+{
+	// Подробности сопоставления из параллельных запусков только перемешались бы
+	_engine_options.verbose = false;
+}
+
+void Tuner::BuildTrees(size_t k)
+{
+	SyncParams params(_base);
+	params.min_duration = _min_durations[k];
+
+	// Фильтры с кэшем нельзя использовать из нескольких потоков
+	std::unique_ptr<PhraseFilter> sync_filter(_sync_filter.Clone()), desync_filter(_desync_filter.Clone());
+	_sync_trees[k].reset( new GroupingTree(_sync, *sync_filter, params) );
+	_desync_trees[k].reset( new GroupingTree(_desync, *desync_filter, params) );
+}
+
+void Tuner::Evaluate(size_t k, TuneResult* result)
+{
+	typedef boost::chrono::steady_clock clock;
+	clock::time_point start = clock::now();
+
+	const SyncParams& params = result->params;
+	PhraseGroups sync_groups, desync_groups;
+	_sync_trees[k]->GetGroups(params.max_offset, sync_groups);
+	_desync_trees[k]->GetGroups(params.max_offset, desync_groups);
+	result->sync_count = sync_groups.size();
+	result->desync_count = desync_groups.size();
+
+	if ( !sync_groups.empty() && !desync_groups.empty() )
+	{
+		DesyncGroups desync_points;
+		SegmentShifts shifts;
+		AlignmentEnginePtr engine = CreateEngine(_engine_name, _engine_options);
+		engine->Align(sync_groups, desync_groups, params, desync_points, shifts);
+
+		// Сдвиг каждой группы; без точек рассинхронизации всё остаётся на месте
+		std::vector<int> group_shifts(desync_groups.size(), 0);
+		std::vector<unsigned int> begins(desync_groups.size());
+		for (SegmentShifts::iterator it = shifts.begin(); it != shifts.end(); ++it)
+		{
+			std::fill(group_shifts.begin() + it->begin, group_shifts.begin() + it->end, it->shift);
+		}
+		for (size_t j = 0; j < desync_groups.size(); ++j)
+		{
+			begins[j] = desync_groups[j].getBegin();
+		}
+
+		// Группа оценочного разбиения сдвигается так же, как группа, в которую попало её начало
+		PhraseGroups shifted(_desync_eval);
+		for (PhraseGroups::iterator it = shifted.begin(); it != shifted.end(); ++it)
+		{
+			size_t j = std::upper_bound(begins.begin(), begins.end(), it->getBegin()) - begins.begin();
+			it->setShift( group_shifts[j > 0 ? j - 1 : 0] );
+		}
+
+		unsigned long long residual = 0;
+		result->matched = CountSyncronized(_sync_eval, shifted, _base, &residual);
+		result->ratio = static_cast<double>(result->matched) / static_cast<double>(std::min(_sync_eval.size(), _desync_eval.size()));
+		result->residual = result->matched > 0 ? static_cast<double>(residual) / result->matched : 0.0;
+	}
+
+	result->ms = boost::chrono::duration<double, boost::milli>(clock::now() - start).count();
+}
+
+size_t Tuner::Run(TuneResults& results)
+{
+	std::vector<int> offsets, desyncs, shifts;
+	TuneValues(_base.min_duration, _min_durations);
+	TuneValues(_base.max_offset, offsets);
+	TuneValues(_base.max_desync, desyncs);
+	TuneValues(_base.max_shift, shifts);
+
+	// Первые деревья строятся в текущем потоке: заодно сортируются фразы,
+	// которые дальше только читаются
+	_sync_trees.resize(_min_durations.size());
+	_desync_trees.resize(_min_durations.size());
+	BuildTrees(0);
+
+	_sync_trees[0]->GetGroups(_base.max_offset, _sync_eval);
+	_desync_trees[0]->GetGroups(_base.max_offset, _desync_eval);
+	if (_sync_eval.empty() || _desync_eval.empty())
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Phrase groups has not been formed"))
+			<< error_message(L"Не сформировано ни одной группы")
+		);
+	}
+
+	ThreadPool pool;
+	for (size_t k = 1; k < _min_durations.size(); ++k)
+	{
+		pool.Submit( boost::bind(&Tuner::BuildTrees, this, k) );
+	}
+	pool.Wait();
+
+	// Все наборы добавляются до запуска, чтобы указатели на результаты не менялись
+	std::vector<size_t> trees;
+	for (size_t k = 0; k < _min_durations.size(); ++k)
+	{
+		for (size_t o = 0; o < offsets.size(); ++o)
+		{
+			for (size_t d = 0; d < desyncs.size(); ++d)
+			{
+				for (size_t s = 0; s < shifts.size(); ++s)
+				{
+					SyncParams params(_base);
+					params.min_duration = _min_durations[k];
+					params.max_offset = offsets[o];
+					params.max_desync = desyncs[d];
+					params.max_shift = shifts[s];
+					results.push_back( TuneResult(params) );
+					trees.push_back(k);
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		pool.Submit( boost::bind(&Tuner::Evaluate, this, trees[i], &results[i]) );
+	}
+	pool.Wait();
+
+	// Больше совпавших групп, при равенстве - меньше расхождение
+	size_t best = 0;
+	for (size_t i = 1; i < results.size(); ++i)
+	{
+		if ( results[i].matched > results[best].matched
+			|| (results[i].matched == results[best].matched && results[i].residual < results[best].residual) )
+		{
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/*****************************/
+/*   Автоподбор параметров   */
+/*****************************/
+size_t AutoTune(PhrasesPtrVector& sync, PhraseFilter& sync_filter, PhrasesPtrVector& desync, PhraseFilter& desync_filter,
+	const SyncParams& base, const std::string& engine_name, const EngineOptions& engine_options, TuneResults& results)
+{
+	return Tuner(sync, sync_filter, desync, desync_filter, base, engine_name, engine_options).Run(results);
+}
+
+void PrintTuneResults(const TuneResults& results, size_t best)
+{
+	std::wclog << L"Подбор параметров, наборов: " << results.size() << std::endl
+		<< L"  min-duration max-offset max-desync max-shift        групп  совпало  расхождение  время, мс" << std::endl;
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const TuneResult& result = results[i];
+
+		std::wostringstream groups;
+		groups << result.sync_count << L" x " << result.desync_count;
+
+		std::wostringstream line;
+		line << (i == best ? L"* " : L"  ")
+			<< std::setw(12) << result.params.min_duration << L' '
+			<< std::setw(10) << result.params.max_offset << L' '
+			<< std::setw(10) << result.params.max_desync << L' '
+			<< std::setw(9) << result.params.max_shift << L' '
+			<< std::setw(12) << groups.str() << L' '
+			<< std::fixed << std::setprecision(1)
+			<< std::setw(7) << result.ratio * 100.0 << L'%' << L' '
+			<< std::setw(9) << result.residual << L" мс" << L' '
+			<< std::setprecision(2) << std::setw(10) << result.ms;
+		std::wclog << line.str() << std::endl;
+	}
+
+	const SyncParams& params = results[best].params;
+	std::wclog << L"Лучшие параметры: --min-duration=" << params.min_duration << L" --max-offset=" << params.max_offset
+		<< L" --max-desync=" << params.max_desync << L" --max-shift=" << params.max_shift << std::endl;
+}
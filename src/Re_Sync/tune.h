@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+#include "resync.h"
+#include "engine.h"
+
+
+/******************************************/
+/*   Результат одного набора параметров   */
+/******************************************/
+class TuneResult
+{
+public:
+	TuneResult(const SyncParams& params)
+		: params(params), sync_count(0), desync_count(0), matched(0), ratio(0.0), residual(0.0), ms(0.0) {};
+
+	SyncParams params;
+	size_t sync_count, desync_count; // Групп при этих параметрах
+	unsigned int matched; // Совпавших групп оценочного разбиения после синхронизации
+	double ratio; // Доля совпавших групп
+	double residual; // Среднее расхождение совпавших групп, мс
+	double ms; // Время группировки, сопоставления и оценки
+};
+
+typedef std::vector<TuneResult> TuneResults;
+
+/*****************************/
+/*   Автоподбор параметров   */
+/*****************************/
+// Перебирает сетку параметров вокруг base на пуле потоков. Все наборы оцениваются на общем
+// разбиении при base: сдвиги переносятся на его группы по времени, и считается, сколько групп
+// совпало с точностью до base.max_desync и с каким средним расхождением.
+// Возвращает номер лучшего набора в results.
+size_t AutoTune(PhrasesPtrVector& sync, PhraseFilter& sync_filter, PhrasesPtrVector& desync, PhraseFilter& desync_filter,
+	const SyncParams& base, const std::string& engine_name, const EngineOptions& engine_options, TuneResults& results);
+void PrintTuneResults(const TuneResults& results, size_t best);
@@ -17,15 +17,25 @@
  * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
  ******************************************************************************/
 
+#include <cstdio>
 #include <cstring>
 #include <locale>
+#include <iostream>
 #include <fstream>
 #include <sstream>
 #include <functional>
 #include <algorithm>
+#include <vector>
+#include <memory>
+
+#include <zlib.h>
+#ifdef RESYNC_WITH_ZSTD
+# include <zstd.h>
+#endif
 
 #include "../nullptr.h"
 #include "../exception.h"
+#include "../hash.h"
 #include "io.h"
 #include "../codecvt/codecvt_cp1251.hpp"
 
@@ -75,120 +85,603 @@ namespace io
 		size_t getBOMSize() { return _bom_size; }
 	};
 
-	/********************/
-	/*   Чтение файла   */
-	/********************/
-	void ReadFile(const std::string& filename, std::wstring& buffer)
+	typedef std::codecvt<wchar_t, char, mbstate_t> Codecvt;
+
+	// Сколько символов преобразуется за раз при записи
+	const size_t ENCODE_CHUNK = 1u << 12;
+
+	// Сколько байт читается за раз
+	const size_t READ_CHUNK = 1u << 16;
+
+	const char STANDARD_STREAM[] = "-";
+
+	static void ThrowIOError(const char* what, const std::wstring& message)
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error(what))
+			<< error_message(message)
+		);
+	}
+
+	bool IsStandardStream(const std::string& filename)
+	{
+		return filename == STANDARD_STREAM;
+	}
+
+	static bool EndsWith(const std::string& filename, const char* suffix)
+	{
+		const size_t size = strlen(suffix);
+		return filename.size() > size && filename.compare(filename.size() - size, size, suffix) == 0;
+	}
+
+	/**************/
+	/*   Сжатие   */
+	/**************/
+	enum Compression {COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD};
+
+	// Ввод - по сигнатуре, вывод - по расширению
+	static Compression DetectCompression(const char* data, size_t size)
+	{
+		if (size >= 2u && memcmp(data, "\x1F\x8B", 2u) == 0) return COMPRESSION_GZIP;
+		if (size >= 4u && memcmp(data, "\x28\xB5\x2F\xFD", 4u) == 0) return COMPRESSION_ZSTD;
+		return COMPRESSION_NONE;
+	}
+
+	static Compression OutputCompression(const std::string& filename)
+	{
+		if (EndsWith(filename, ".gz")) return COMPRESSION_GZIP;
+		if (EndsWith(filename, ".zst")) return COMPRESSION_ZSTD;
+		return COMPRESSION_NONE;
+	}
+
+#ifndef RESYNC_WITH_ZSTD
+	static void ThrowNoZstd()
 	{
-		char buf[MAX_BOM + 1u];
-		std::ifstream fin(filename.c_str(), std::ios_base::binary);
-		fin.imbue(std::locale::classic());
-		if (!fin.is_open())
+		ThrowIOError("Built without zstd", L"Программа собрана без поддержки zstd");
+	}
+#endif
+
+	// Распаковка по частям: каждая часть сжатых данных сразу даёт свою часть текста
+	class Decompressor
+	{
+		Compression _type;
+		z_stream _zlib;
+#ifdef RESYNC_WITH_ZSTD
+		ZSTD_DCtx* _zstd;
+#endif
+		bool _finished; // Поток закончен, дальше может начаться следующий
+		std::vector<char> _out;
+
+		Decompressor(const Decompressor&);
+		Decompressor& operator=(const Decompressor&);
+
+		static void ThrowCorrupted()
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Сan't open file for reading"))
-				<< error_message(L"Ошибка открытия файла для чтения")
-			);
+			ThrowIOError("Corrupted compressed data", L"Повреждённые сжатые данные");
 		}
 
-		fin.read(buf, MAX_BOM);
-		if (!fin.good())
+	public:
+		explicit Decompressor(Compression type) : _type(type), _finished(false), _out(READ_CHUNK)
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("File too small"))
-				<< error_message(L"Слишком маленький файл")
-			);
+			memset(&_zlib, 0, sizeof(_zlib));
+			if (_type == COMPRESSION_GZIP)
+			{
+				// 16 - только gzip
+				if (inflateInit2(&_zlib, 15 + 16) != Z_OK) ThrowCorrupted();
+			}
+			else
+			{
+#ifdef RESYNC_WITH_ZSTD
+				_zstd = ZSTD_createDCtx();
+				if (_zstd == nullptr) ThrowCorrupted();
+#else
+				ThrowNoZstd();
+#endif
+			}
 		}
-		fin.close();
 
-		std::wifstream wfin(filename.c_str(), std::ios_base::binary);
-		if (!wfin.is_open())
+		~Decompressor()
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Сan't reopen file for reading"))
-				<< error_message(L"Ошибка переоткрытия файла для чтения")
-			);
+			if (_type == COMPRESSION_GZIP) inflateEnd(&_zlib);
+#ifdef RESYNC_WITH_ZSTD
+			if (_type == COMPRESSION_ZSTD) ZSTD_freeDCtx(_zstd);
+#endif
 		}
 
-		std::codecvt<wchar_t, char, mbstate_t>* facet = nullptr;
+		// Распакованное из очередной части - в out
+		void Feed(const char* data, size_t size, std::string& out)
+		{
+			out.clear();
+			if (_type == COMPRESSION_GZIP)
+			{
+				_zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+				_zlib.avail_in = static_cast<uInt>(size);
+				for (;;)
+				{
+					// Несколько склеенных gzip подряд, как у gzip -d
+					if (_finished)
+					{
+						if (_zlib.avail_in == 0) break;
+						if (inflateReset(&_zlib) != Z_OK) ThrowCorrupted();
+						_finished = false;
+					}
+					_zlib.next_out = reinterpret_cast<Bytef*>(&_out[0]);
+					_zlib.avail_out = static_cast<uInt>(_out.size());
+					const int result = inflate(&_zlib, Z_NO_FLUSH);
+					if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) ThrowCorrupted();
+					out.append(&_out[0], _out.size() - _zlib.avail_out);
+					if (result == Z_STREAM_END) _finished = true;
+					// Место в выходном буфере осталось - вход разобран весь
+					else if (_zlib.avail_out > 0) break;
+				}
+				return;
+			}
+
+#ifdef RESYNC_WITH_ZSTD
+			ZSTD_inBuffer in = {data, size, 0};
+			ZSTD_outBuffer buffer;
+			do
+			{
+				buffer.dst = &_out[0];
+				buffer.size = _out.size();
+				buffer.pos = 0;
+				const size_t result = ZSTD_decompressStream(_zstd, &buffer, &in);
+				if (ZSTD_isError(result)) ThrowCorrupted();
+				out.append(&_out[0], buffer.pos);
+				_finished = result == 0;
+			}
+			while (in.pos < in.size || buffer.pos == buffer.size);
+#endif
+		}
 
-		Codepage utf8("\xEF\xBB\xBF", new std::codecvt_byname<wchar_t, char, mbstate_t>("ru_RU.UTF-8"));
-		if (facet == nullptr && utf8.isMyBOM(buf))
+		// Оборванный поток - ошибка, а не часть текста
+		void Finish()
 		{
-			facet = utf8.getFacet();
-			wfin.seekg(utf8.getBOMSize());
+			if (!_finished) ThrowCorrupted();
 		}
-		
-		Codepage utf16le("\xFF\xFE", nullptr);
-		if (facet == nullptr && utf16le.isMyBOM(buf))
+	};
+
+	/*************************************/
+	/*   Преобразование по мере чтения   */
+	/*************************************/
+	// Кодировка определяется по первым байтам, неполный многобайтный символ
+	// на конце части ждёт следующую
+	class Decoder
+	{
+		std::locale _locale;
+		bool _ready, _failed;
+		mbstate_t _state;
+		std::string _pending; // Непреобразованные байты с прошлого раза
+
+		void SelectFacet(const char* data, size_t size, size_t& skip)
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("UTF-16LE not supported yet"))
-				<< error_message(L"UTF-16LE пока не поддерживается")
-			);
+			char buf[MAX_BOM + 1u] = {0};
+			if (size > 0) memcpy(buf, data, std::min(size, MAX_BOM));
+
+			Codecvt* facet = nullptr;
+			skip = 0;
+
+			Codepage utf8("\xEF\xBB\xBF", nullptr);
+			if (facet == nullptr && utf8.isMyBOM(buf))
+			{
+				facet = new std::codecvt_byname<wchar_t, char, mbstate_t>("ru_RU.UTF-8");
+				skip = utf8.getBOMSize();
+			}
+
+			Codepage utf16le("\xFF\xFE", nullptr);
+			if (facet == nullptr && utf16le.isMyBOM(buf))
+			{
+				ThrowIOError("UTF-16LE not supported yet", L"UTF-16LE пока не поддерживается");
+			}
+
+			Codepage utf16be("\xFE\xFF", nullptr);
+			if (facet == nullptr && utf16be.isMyBOM(buf))
+			{
+				ThrowIOError("UTF-16BE not supported yet", L"UTF-16BE пока не поддерживается");
+			}
+
+			if (facet == nullptr) facet = new codecvt_cp1251;
+
+			// Локаль владеет фасетом
+			_locale = std::locale(std::locale::classic(), facet);
 		}
-		
-		Codepage utf16be("\xFE\xFF", nullptr);
-		if (facet == nullptr && utf16be.isMyBOM(buf))
+
+	public:
+		Decoder() : _ready(false), _failed(false), _state() {};
+
+		// Дописывает в buffer текст очередной части; last - частей больше не будет
+		void Feed(const char* data, size_t size, bool last, std::wstring& buffer)
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("UTF-16BE not supported yet"))
-				<< error_message(L"UTF-16BE пока не поддерживается")
-			);
+			// Без остатка прошлой части преобразуем прямо из data, не копируя
+			if ( !_pending.empty() || (!_ready && size < MAX_BOM && !last) )
+			{
+				if (size > 0) _pending.append(data, size);
+				if (!_ready && _pending.size() < MAX_BOM && !last) return;
+				data = _pending.data();
+				size = _pending.size();
+			}
+
+			if (!_ready)
+			{
+				size_t skip;
+				SelectFacet(data, size, skip);
+				skip = std::min(skip, size);
+				data += skip;
+				size -= skip;
+				_ready = true;
+			}
+			if (_failed || size == 0) return;
+
+			// Символов не больше, чем байт. Как и при чтении потоком, на ошибке текст обрывается.
+			const Codecvt& cvt = std::use_facet<Codecvt>(_locale);
+			const size_t old_size = buffer.size();
+			buffer.resize(old_size + size);
+			const char* from_next = nullptr;
+			wchar_t* to_next = nullptr;
+			std::codecvt_base::result result = cvt.in(_state, data, data + size, from_next, &buffer[old_size], &buffer[0] + buffer.size(), to_next);
+			buffer.resize(to_next - &buffer[0]);
+
+			if (result == std::codecvt_base::error) _failed = true;
+			std::string rest;
+			if (!_failed && !last) rest.assign(from_next, data + size);
+			_pending.swap(rest);
 		}
+	};
 
-		if (facet == nullptr) facet = new codecvt_cp1251;
-		
-		wfin.imbue(std::locale(std::locale::classic(), facet));
+	/********************/
+	/*   Чтение файла   */
+	/********************/
+	// Файл или стандартный ввод читается частями; с decoder каждая часть
+	// преобразуется сразу, пока читается следующая. Части копируются в data и
+	// добавляются к hash, только если они заданы; size - размер распакованного.
+	static void Read(const std::string& filename, std::string* data, Decoder* decoder, std::wstring* buffer,
+		XXHash64State* hash, unsigned long long& size)
+	{
+		InputStream in(filename);
+		if (data != nullptr) data->clear();
+		size = 0;
+		std::vector<char> chunk(READ_CHUNK);
+		for (;;)
+		{
+			const size_t count = in.Read(&chunk[0], chunk.size());
+			if (count == 0) break;
+
+			size += count;
+			if (data != nullptr) data->append(&chunk[0], count);
+			if (hash != nullptr) hash->Update(&chunk[0], count);
+			if (decoder != nullptr) decoder->Feed(&chunk[0], count, false, *buffer);
+		}
+
+		if (size < MAX_BOM)
+		{
+			ThrowIOError("File too small", L"Слишком маленький файл");
+		}
+		if (decoder != nullptr) decoder->Feed(nullptr, 0, true, *buffer);
+	}
+
+	void ReadData(const std::string& filename, std::string& data)
+	{
+		unsigned long long size;
+		Read(filename, &data, nullptr, nullptr, nullptr, size);
+	}
+
+	void ReadText(const std::string& filename, std::wstring& buffer, unsigned long long* hash, unsigned long long* size)
+	{
+		buffer.clear();
+		Decoder decoder;
+		XXHash64State state;
+		unsigned long long read_size;
+		Read(filename, nullptr, &decoder, &buffer, hash != nullptr ? &state : nullptr, read_size);
+		if (hash != nullptr) *hash = state.Digest();
+		if (size != nullptr) *size = read_size;
+	}
+
+	void Decompress(std::string& data)
+	{
+		const Compression compression = DetectCompression(data.data(), data.size());
+		if (compression == COMPRESSION_NONE) return;
 
-		std::wostringstream woss;
-		woss << wfin.rdbuf();
-		wfin.close();
+		Decompressor decompressor(compression);
+		std::string unpacked;
+		decompressor.Feed(data.data(), data.size(), unpacked);
+		decompressor.Finish();
+		data.swap(unpacked);
+	}
 
-		woss.str().swap(buffer);
+	void ReadFile(const std::string& filename, std::wstring& buffer)
+	{
+		ReadText(filename, buffer);
 	}
 
 	/********************/
 	/*   Запись файла   */
 	/********************/
+	// Текст преобразуется и записывается по частям, без копии целиком
+	class OutputSink
+	{
+		OutputStream& _out;
+	public:
+		OutputSink(OutputStream& out) : _out(out) {};
+		void operator()(const char* data, size_t size) { _out.Write(data, size); }
+	};
+
+	class StringSink
+	{
+		std::string& _data;
+	public:
+		StringSink(std::string& data) : _data(data) {};
+		void operator()(const char* data, size_t size) { _data.append(data, size); }
+	};
+
+	// Сжимает по частям и пишет в поток
+	class CompressSink
+	{
+		Compression _type;
+		std::ostream& _out;
+		z_stream _zlib;
+#ifdef RESYNC_WITH_ZSTD
+		ZSTD_CCtx* _zstd;
+#endif
+		std::vector<char> _buffer;
+
+		CompressSink(const CompressSink&);
+		CompressSink& operator=(const CompressSink&);
+
+		static void ThrowCompressError()
+		{
+			ThrowIOError("Compression error", L"Ошибка сжатия");
+		}
+
+		void Compress(const char* data, size_t size, bool finish)
+		{
+			if (_type == COMPRESSION_GZIP)
+			{
+				_zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+				_zlib.avail_in = static_cast<uInt>(size);
+				int result;
+				do
+				{
+					_zlib.next_out = reinterpret_cast<Bytef*>(&_buffer[0]);
+					_zlib.avail_out = static_cast<uInt>(_buffer.size());
+					result = deflate(&_zlib, finish ? Z_FINISH : Z_NO_FLUSH);
+					if (result == Z_STREAM_ERROR) ThrowCompressError();
+					_out.write(&_buffer[0], _buffer.size() - _zlib.avail_out);
+				}
+				while (_zlib.avail_out == 0 || (finish && result != Z_STREAM_END));
+				return;
+			}
+
+#ifdef RESYNC_WITH_ZSTD
+			ZSTD_inBuffer in = {data, size, 0};
+			size_t remaining;
+			do
+			{
+				ZSTD_outBuffer out = {&_buffer[0], _buffer.size(), 0};
+				remaining = ZSTD_compressStream2(_zstd, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+				if (ZSTD_isError(remaining)) ThrowCompressError();
+				_out.write(&_buffer[0], out.pos);
+			}
+			while (finish ? remaining != 0 : in.pos < in.size);
+#endif
+		}
+
+	public:
+		CompressSink(Compression type, std::ostream& out) : _type(type), _out(out), _buffer(READ_CHUNK)
+		{
+			memset(&_zlib, 0, sizeof(_zlib));
+			if (_type == COMPRESSION_GZIP)
+			{
+				if (deflateInit2(&_zlib, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) ThrowCompressError();
+			}
+			else
+			{
+#ifdef RESYNC_WITH_ZSTD
+				_zstd = ZSTD_createCCtx();
+				if (_zstd == nullptr) ThrowCompressError();
+#else
+				ThrowNoZstd();
+#endif
+			}
+		}
+
+		~CompressSink()
+		{
+			if (_type == COMPRESSION_GZIP) deflateEnd(&_zlib);
+#ifdef RESYNC_WITH_ZSTD
+			if (_type == COMPRESSION_ZSTD) ZSTD_freeCCtx(_zstd);
+#endif
+		}
+
+		void operator()(const char* data, size_t size) { Compress(data, size, false); }
+		void Finish() { Compress(nullptr, 0, true); }
+	};
+
+	template <typename Sink>
+	static void EncodeParts(const std::wstring& buffer, bool write_bom, Sink& sink);
+
 	void WriteFile(const std::string& filename, const std::wstring& buffer, bool write_bom)
 	{
-		std::wofstream wfout;
-		if (write_bom)
+		OutputStream out(filename);
+		OutputSink sink(out);
+		EncodeParts(buffer, write_bom, sink);
+		out.Close();
+	}
+
+	/*********************/
+	/*   Потоки байтов   */
+	/*********************/
+	InputStream::InputStream(const std::string& filename) : _in(&std::cin), _first(true), _eof(false), _offset(0)
+	{
+		if ( !IsStandardStream(filename) )
+		{
+			_fin.open(filename.c_str(), std::ios_base::binary);
+			if (!_fin.is_open())
+			{
+				ThrowIOError("Сan't open file for reading", L"Ошибка открытия файла для чтения");
+			}
+			_in = &_fin;
+		}
+	}
+
+	InputStream::~InputStream()
+	{
+	}
+
+	size_t InputStream::ReadRaw(char* data, size_t size)
+	{
+		_in->read(data, size);
+		if ( _in->bad() )
+		{
+			ThrowIOError("File read error", L"Ошибка чтения файла");
+		}
+		return static_cast<size_t>(_in->gcount());
+	}
+
+	size_t InputStream::Read(char* data, size_t size)
+	{
+		for (;;)
 		{
-			std::ofstream fout(filename.c_str(), std::ios_base::binary);
-			fout.imbue(std::locale::classic());
-			if (!fout.is_open())
+			if (_offset < _unpacked.size())
+			{
+				const size_t count = std::min(size, _unpacked.size() - _offset);
+				memcpy(data, _unpacked.data() + _offset, count);
+				_offset += count;
+				return count;
+			}
+			if (_eof) return 0;
+
+			// Несжатый ввод после первой части читается прямо в data
+			if (!_first && !_decompressor) return ReadRaw(data, size);
+
+			_chunk.resize(READ_CHUNK);
+			const size_t count = ReadRaw(&_chunk[0], _chunk.size());
+			if (count == 0)
 			{
-				BOOST_THROW_EXCEPTION(
-					boost::enable_error_info(std::runtime_error("Сan't open file for writing"))
-					<< error_message(L"Ошибка открытия файла для записи")
-				);
+				if (_decompressor) _decompressor->Finish();
+				_eof = true;
+				return 0;
 			}
-			fout.write("\xEF\xBB\xBF", 3);
-			fout.close();
 
-			wfout.open(filename.c_str(), std::ios_base::binary | std::ios_base::app);
+			// Первая часть - весь ввод или READ_CHUNK байт, сигнатуры хватает
+			if (_first)
+			{
+				const Compression compression = DetectCompression(_chunk.data(), count);
+				if (compression != COMPRESSION_NONE) _decompressor.reset( new Decompressor(compression) );
+				_first = false;
+			}
+			if (_decompressor)
+			{
+				_decompressor->Feed(_chunk.data(), count, _unpacked);
+			}
+			else
+			{
+				_unpacked.assign(_chunk.data(), count);
+			}
+			_offset = 0;
+		}
+	}
+
+	OutputStream::OutputStream(const std::string& filename) : _name(filename), _out(&std::cout), _closed(false)
+	{
+		// Стандартный вывод не сжимается: его сожмёт следующая команда конвейера
+		if ( IsStandardStream(filename) ) return;
+
+		// Без zstd ошибка - до создания файла, чтобы не оставить пустой
+		const Compression compression = OutputCompression(filename);
+#ifndef RESYNC_WITH_ZSTD
+		if (compression == COMPRESSION_ZSTD) ThrowNoZstd();
+#endif
+
+		_fout.open(filename.c_str(), std::ios_base::binary);
+		if (!_fout.is_open())
+		{
+			ThrowIOError("Сan't open file for writing", L"Ошибка открытия файла для записи");
+		}
+		_out = &_fout;
+		try
+		{
+			if (compression != COMPRESSION_NONE) _compress.reset( new CompressSink(compression, _fout) );
+		}
+		catch (...)
+		{
+			_fout.close();
+			std::remove(_name.c_str());
+			throw;
+		}
+	}
+
+	OutputStream::~OutputStream()
+	{
+		if (_closed || !_fout.is_open()) return;
+		_fout.close();
+		std::remove(_name.c_str());
+	}
+
+	void OutputStream::Write(const char* data, size_t size)
+	{
+		if (_compress)
+		{
+			(*_compress)(data, size);
 		}
 		else
 		{
-			wfout.open(filename.c_str(), std::ios_base::binary);
+			_out->write(data, size);
 		}
+	}
 
-		if (!wfout.is_open())
+	void OutputStream::Close()
+	{
+		if (_compress) _compress->Finish();
+		_out->flush();
+		if (_fout.is_open()) _fout.close();
+		if (!*_out)
 		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Сan't reopen file for writing"))
-				<< error_message(L"Ошибка переоткрытия файла для записи")
-			);
+			ThrowIOError("File write error", L"Ошибка записи файла");
 		}
+		_closed = true;
+	}
+
+	/**************************************/
+	/*   Преобразование текста в памяти   */
+	/**************************************/
+	void Decode(const char* data, size_t size, std::wstring& buffer)
+	{
+		buffer.clear();
+		Decoder decoder;
+		decoder.Feed(data, size, true, buffer);
+	}
+
+	void Encode(const std::wstring& buffer, std::string& data, bool write_bom)
+	{
+		data.clear();
+		StringSink sink(data);
+		EncodeParts(buffer, write_bom, sink);
+	}
+
+	template <typename Sink>
+	static void EncodeParts(const std::wstring& buffer, bool write_bom, Sink& sink)
+	{
+		std::locale locale(std::locale::classic(), new std::codecvt_byname<wchar_t, char, mbstate_t>("ru_RU.UTF-8"));
+		const Codecvt& cvt = std::use_facet<Codecvt>(locale);
+
+		if (write_bom) sink("\xEF\xBB\xBF", 3);
 
-		std::codecvt<wchar_t, char, mbstate_t>* facet = nullptr;
-		facet = new std::codecvt_byname<wchar_t, char, mbstate_t>("ru_RU.UTF-8");
-		
-		wfout.imbue(std::locale(std::locale::classic(), facet));
+		std::vector<char> out(ENCODE_CHUNK * cvt.max_length());
+		mbstate_t state = mbstate_t();
+		const wchar_t* from = buffer.data();
+		const wchar_t* const end = buffer.data() + buffer.size();
+		while (from != end)
+		{
+			const wchar_t* from_next = nullptr;
+			char* to_next = nullptr;
+			std::codecvt_base::result result = cvt.out(state, from, std::min(from + ENCODE_CHUNK, end), from_next, &out[0], &out[0] + out.size(), to_next);
+			if (result == std::codecvt_base::error || from_next == from)
+			{
+				ThrowIOError("Can't convert encoding", L"Ошибка преобразования кодировки");
+			}
 
-		wfout << buffer;
-		wfout.close();
+			sink(&out[0], to_next - &out[0]);
+			from = from_next;
+		}
 	}
 }
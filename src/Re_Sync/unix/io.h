@@ -1,10 +1,83 @@
 ﻿#pragma once
 
 #include <string>
+#include <fstream>
+#include <memory>
+
+#include "../nullptr.h"
 
 
 namespace io
 {
+	// Имя "-" - стандартный ввод при чтении и стандартный вывод при записи
+	bool IsStandardStream(const std::string& filename);
+
+	// Файлы gzip и zstd распаковываются при чтении, определяясь по сигнатуре, и сжимаются
+	// при записи в файл с расширением .gz или .zst. Стандартный вывод не сжимается.
+	// Распаковка уже прочитанных данных, если они сжаты
+	void Decompress(std::string& data);
+
 	void ReadFile(const std::string& filename, std::wstring& buffer);
+	// Содержимое файла без преобразования
+	void ReadData(const std::string& filename, std::string& data);
+	// Текст, преобразованный по мере чтения; сами байты не хранятся.
+	// hash - XXHash64 распакованного содержимого, size - его размер
+	void ReadText(const std::string& filename, std::wstring& buffer, unsigned long long* hash = nullptr, unsigned long long* size = nullptr);
+	// Текст преобразуется и выводится по частям
 	void WriteFile(const std::string& filename, const std::wstring& buffer, bool write_bom = true);
+
+	class Decompressor;
+	class CompressSink;
+
+	// Байты файла или стандартного ввода по частям, без преобразования кодировки.
+	// Сжатый ввод распаковывается, как у ReadData.
+	class InputStream
+	{
+	public:
+		explicit InputStream(const std::string& filename);
+		~InputStream();
+
+		// Сколько байт прочитано в data, 0 - ввод закончился
+		size_t Read(char* data, size_t size);
+
+	private:
+		InputStream(const InputStream&);
+		InputStream& operator=(const InputStream&);
+
+		size_t ReadRaw(char* data, size_t size);
+
+		std::ifstream _fin;
+		std::istream* _in;
+		bool _first, _eof;
+		std::unique_ptr<Decompressor> _decompressor;
+		std::string _chunk, _unpacked; // Прочитанное, но ещё не отданное - с _offset
+		size_t _offset;
+	};
+
+	// Байты в файл или стандартный вывод по частям. Файл .gz или .zst сжимается, как у WriteFile.
+	// Если до Close что-то пошло не так, недописанный файл удаляется.
+	class OutputStream
+	{
+	public:
+		explicit OutputStream(const std::string& filename);
+		~OutputStream();
+
+		void Write(const char* data, size_t size);
+		// Исключение, если что-то не записалось
+		void Close();
+
+	private:
+		OutputStream(const OutputStream&);
+		OutputStream& operator=(const OutputStream&);
+
+		std::string _name;
+		std::ofstream _fout;
+		std::ostream* _out;
+		std::unique_ptr<CompressSink> _compress;
+		bool _closed;
+	};
+
+	// Кодировка определяется по BOM, как при чтении файла; запись - в UTF-8
+	void Decode(const char* data, size_t size, std::wstring& buffer);
+	void Encode(const std::wstring& buffer, std::string& data, bool write_bom = true);
 }
@@ -0,0 +1,689 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <boost/chrono.hpp>
+
+#include "../nullptr.h"
+#include "../exception.h"
+#include "../script.h"
+#include "../index.h"
+#include "../hash.h"
+#include "io.h"
+#include "server.h"
+
+
+namespace server
+{
+	typedef boost::chrono::steady_clock ServerClock;
+
+	const size_t MAX_REQUEST = 1u << 16;
+	const size_t MAX_FDS = 4;
+	// Синхронизированных скриптов в памяти
+	const size_t CACHE_SIZE = 8;
+	// Сколько ждать запрос от подключившегося клиента, с
+	const int RECEIVE_TIMEOUT = 5;
+
+	static volatile sig_atomic_t stop_requested = 0;
+
+	static void OnStopSignal(int)
+	{
+		stop_requested = 1;
+	}
+
+	static void ThrowError(const char* what, const std::wstring& message)
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error(what))
+			<< error_message(message)
+		);
+	}
+
+	static std::wstring ErrorText(const std::exception& e)
+	{
+		if ( std::wstring const* info = boost::get_error_info<error_message>(e) )
+		{
+			return *info;
+		}
+		const char* what = e.what();
+		return std::wstring(what, what + strlen(what));
+	}
+
+	static void SocketAddress(const std::string& socket_name, sockaddr_un& address)
+	{
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (socket_name.empty() || socket_name.size() >= sizeof(address.sun_path))
+		{
+			ThrowError("Wrong socket name", L"Неправильное имя сокета");
+		}
+		memcpy(address.sun_path, socket_name.c_str(), socket_name.size());
+	}
+
+	static void WriteAll(int fd, const char* data, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t written = write(fd, data, size);
+			if (written < 0 && errno == EINTR) continue;
+			if (written <= 0)
+			{
+				ThrowError("Socket write error", L"Ошибка записи в сокет");
+			}
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+	}
+
+	// Чтение до конца
+	static void ReadDescriptor(int fd, std::string& data)
+	{
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			ThrowError("Can't stat file", L"Ошибка чтения файла");
+		}
+
+		data.clear();
+		if (S_ISREG(st.st_mode)) data.reserve(static_cast<size_t>(st.st_size));
+		char buffer[1u << 16];
+		for (;;)
+		{
+			const ssize_t count = read(fd, buffer, sizeof(buffer));
+			if (count < 0 && errno == EINTR) continue;
+			if (count < 0)
+			{
+				ThrowError("File read error", L"Ошибка чтения файла");
+			}
+			if (count == 0) break;
+			data.append(buffer, static_cast<size_t>(count));
+		}
+
+		if (data.size() < 3u)
+		{
+			ThrowError("File too small", L"Слишком маленький файл");
+		}
+	}
+
+	/********************************************/
+	/*   Открытый дескриптор, закрываемый сам   */
+	/********************************************/
+	class Descriptor
+	{
+		int _fd;
+
+		Descriptor(const Descriptor&);
+		Descriptor& operator=(const Descriptor&);
+
+	public:
+		explicit Descriptor(int fd = -1) : _fd(fd) {};
+		~Descriptor() { reset(); }
+
+		void reset(int fd = -1)
+		{
+			if (_fd >= 0) close(_fd);
+			_fd = fd;
+		}
+		int get() const { return _fd; }
+	};
+
+	/****************************************/
+	/*   Сгруппированный эталонный скрипт   */
+	/****************************************/
+	class Reference
+	{
+	public:
+		explicit Reference(const KeywordFilter& keywords) : script(keywords) {};
+
+		SubtitleScript script; // У индекса пустой
+		PhraseGroups groups; // После загрузки только читаются
+	};
+	typedef std::shared_ptr<Reference> ReferencePtr;
+
+	/***********************************************************/
+	/*   Последние использованные синхронизированные скрипты   */
+	/***********************************************************/
+	class ReferenceCache
+	{
+		typedef std::list< std::pair<std::string, ReferencePtr> > Entries;
+		Entries _entries; // Сначала самые свежие
+
+	public:
+		ReferenceCache() : hits(0), misses(0) {};
+
+		ReferencePtr Find(const std::string& key)
+		{
+			for (Entries::iterator it = _entries.begin(); it != _entries.end(); ++it)
+			{
+				if (it->first == key)
+				{
+					_entries.splice(_entries.begin(), _entries, it);
+					++hits;
+					return it->second;
+				}
+			}
+			++misses;
+			return ReferencePtr();
+		}
+
+		void Insert(const std::string& key, const ReferencePtr& reference)
+		{
+			_entries.push_front( std::make_pair(key, reference) );
+			if (_entries.size() > CACHE_SIZE) _entries.pop_back();
+		}
+
+		unsigned long long hits, misses;
+	};
+
+	/**************/
+	/*   Запрос   */
+	/**************/
+	class Query
+	{
+	public:
+		Query() : sync_fd(-1), desync_fd(-1), unchanged(false) {};
+
+		std::string sync_name, desync_name;
+		int sync_fd, desync_fd; // Номера переданных дескрипторов
+		bool unchanged; // Вернуть синхронный скрипт как есть
+		SyncParams params;
+		std::string engine_name;
+	};
+
+	static int ParseNumber(const std::string& value)
+	{
+		char* end = nullptr;
+		const long number = strtol(value.c_str(), &end, 10);
+		if (value.empty() || *end != '\0' || number < 0 || number > 0x7FFFFFFFL)
+		{
+			ThrowError("Wrong request value", L"Неправильное значение в запросе");
+		}
+		return static_cast<int>(number);
+	}
+
+	static void ParseRequest(const std::string& text, Query& request)
+	{
+		std::istringstream iss(text);
+		std::string line;
+		while ( std::getline(iss, line) && !line.empty() )
+		{
+			const size_t space = line.find(' ');
+			const std::string key = line.substr(0, space);
+			const std::string value = space == std::string::npos ? std::string() : line.substr(space + 1);
+
+			if      (key == "sync")          request.sync_name = value;
+			else if (key == "desync")        request.desync_name = value;
+			else if (key == "sync-fd")       request.sync_fd = ParseNumber(value);
+			else if (key == "desync-fd")     request.desync_fd = ParseNumber(value);
+			else if (key == "min-duration")  request.params.min_duration = ParseNumber(value);
+			else if (key == "max-offset")    request.params.max_offset = ParseNumber(value);
+			else if (key == "max-desync")    request.params.max_desync = ParseNumber(value);
+			else if (key == "max-shift")     request.params.max_shift = ParseNumber(value);
+			else if (key == "skip-lyrics")   request.params.skip_lyrics = ParseNumber(value) != 0;
+			else if (key == "no-skip")       request.params.no_skip = ParseNumber(value) != 0;
+			else if (key == "allow-overlap") request.params.allow_overlap = ParseNumber(value) != 0;
+			else if (key == "engine")        request.engine_name = value;
+			else if (key == "unchanged")     request.unchanged = ParseNumber(value) != 0;
+			else
+			{
+				ThrowError("Unknown request key", L"Неизвестный ключ запроса: " + std::wstring(key.begin(), key.end()));
+			}
+		}
+	}
+
+	/*************/
+	/*   Демон   */
+	/*************/
+	class Server
+	{
+	public:
+		Server(const KeywordFilter& keywords, unsigned long long keywords_hash, const SyncParams& params, const std::string& engine_name,
+			const EngineOptions& engine_options, bool verbose)
+			: _keywords(keywords), _keywords_hash(keywords_hash), _params(params), _engine_name(engine_name), _engine_options(engine_options), _verbose(verbose)
+		{
+			// Подробности сопоставления ушли бы в журнал демона, а не клиенту
+			_engine_options.verbose = false;
+		}
+
+		void Handle(int client);
+
+	private:
+		// Запрос и переданные с ним дескрипторы
+		void Receive(int client, std::string& text, std::vector<int>& fds);
+		// Обработка запроса; false - субтитры синхронны, out_data - скрипт как есть, если запрошен
+		bool Process(const Query& request, const std::vector<int>& fds, std::string& out_data, bool& cached);
+		int OpenInput(const std::string& name, int index, const std::vector<int>& fds, Descriptor& owned);
+		AlignmentEngine& Engine(const std::string& name);
+
+		const KeywordFilter& _keywords;
+		unsigned long long _keywords_hash;
+		const SyncParams& _params;
+		const std::string& _engine_name;
+		EngineOptions _engine_options;
+		bool _verbose;
+
+		ReferenceCache _cache;
+		std::map< std::string, std::shared_ptr<AlignmentEngine> > _engines;
+	};
+
+	void Server::Receive(int client, std::string& text, std::vector<int>& fds)
+	{
+		char buffer[4096];
+		char control[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+		while (text.find("\n\n") == std::string::npos)
+		{
+			iovec iov;
+			iov.iov_base = buffer;
+			iov.iov_len = sizeof(buffer);
+
+			msghdr message;
+			memset(&message, 0, sizeof(message));
+			message.msg_iov = &iov;
+			message.msg_iovlen = 1;
+			message.msg_control = control;
+			message.msg_controllen = sizeof(control);
+
+			const ssize_t count = recvmsg(client, &message, MSG_CMSG_CLOEXEC);
+			if (count < 0 && errno == EINTR && !stop_requested) continue;
+
+			for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+			{
+				if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+				{
+					const size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+					for (size_t i = 0; i < n; ++i)
+					{
+						int fd;
+						memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+						fds.push_back(fd);
+					}
+				}
+			}
+
+			if (count <= 0)
+			{
+				ThrowError("Incomplete request", L"Неполный запрос");
+			}
+			text.append(buffer, static_cast<size_t>(count));
+			if (text.size() > MAX_REQUEST)
+			{
+				ThrowError("Request too large", L"Слишком большой запрос");
+			}
+		}
+	}
+
+	int Server::OpenInput(const std::string& name, int index, const std::vector<int>& fds, Descriptor& owned)
+	{
+		if (index >= 0)
+		{
+			if (static_cast<size_t>(index) >= fds.size())
+			{
+				ThrowError("Descriptor not passed", L"Дескриптор не передан");
+			}
+			return fds[index];
+		}
+		if (name.empty())
+		{
+			ThrowError("Script not specified", L"Не указан скрипт");
+		}
+		owned.reset( open(name.c_str(), O_RDONLY | O_CLOEXEC) );
+		if (owned.get() < 0)
+		{
+			ThrowError("Can't open file for reading", L"Ошибка открытия файла для чтения");
+		}
+		return owned.get();
+	}
+
+	AlignmentEngine& Server::Engine(const std::string& name)
+	{
+		std::shared_ptr<AlignmentEngine>& engine = _engines[name];
+		if (!engine)
+		{
+			try
+			{
+				engine.reset( CreateEngine(name, _engine_options).release() );
+			}
+			catch (...)
+			{
+				_engines.erase(name);
+				throw;
+			}
+		}
+		return *engine;
+	}
+
+	bool Server::Process(const Query& request, const std::vector<int>& fds, std::string& out_data, bool& cached)
+	{
+		// Синхронизированный скрипт или его индекс из кэша, если не изменились содержимое
+		// и параметры группировки. Файл читается целиком в любом случае, поэтому ключ -
+		// хэш содержимого: время изменения не различает правки в пределах секунды.
+		// Хэшируется распакованное содержимое, как в кэше результатов и индексе,
+		// чтобы сжатая и обычная копии скрипта занимали одно место.
+		Descriptor sync_owned;
+		const int sync_fd = OpenInput(request.sync_name, request.sync_fd, fds, sync_owned);
+		std::string data;
+		ReadDescriptor(sync_fd, data);
+		io::Decompress(data);
+
+		const SyncParams& params = request.params;
+		std::ostringstream key;
+		key << XXHash64(data.data(), data.size()) << '|' << params.min_duration << ':' << params.max_offset << ':' << params.skip_lyrics << params.no_skip << params.allow_overlap;
+
+		ReferencePtr reference = _cache.Find(key.str());
+		cached = static_cast<bool>(reference);
+		if (!reference)
+		{
+			reference.reset( new Reference(_keywords) );
+			if ( IsReferenceIndex(data.data(), data.size()) )
+			{
+				LoadReferenceIndex(data.data(), data.size(), params, _keywords_hash, reference->groups);
+			}
+			else
+			{
+				std::wstring content;
+				io::Decode(data.data(), data.size(), content);
+				reference->script.Load(content);
+				reference->script.Group(params, reference->groups);
+			}
+			_cache.Insert(key.str(), reference);
+		}
+
+		// Рассинхронизированный скрипт каждый раз новый
+		Descriptor desync_owned;
+		const int desync_fd = OpenInput(request.desync_name, request.desync_fd, fds, desync_owned);
+		ReadDescriptor(desync_fd, data);
+		io::Decompress(data);
+
+		SubtitleScript script(_keywords);
+		{
+			std::wstring content;
+			io::Decode(data.data(), data.size(), content);
+			script.Load(content);
+		}
+		PhraseGroups groups;
+		script.Group(params, groups);
+
+		DesyncGroups desync_points;
+		SegmentShifts shifts;
+		Engine(request.engine_name).Align(reference->groups, groups, params, desync_points, shifts);
+		if (desync_points.empty() && !request.unchanged) return false;
+
+		if ( !desync_points.empty() )
+		{
+			PhraseGroups result;
+			script.Shift(groups, shifts, result);
+		}
+		std::wstring out_content;
+		script.Generate(out_content);
+		io::Encode(out_content, out_data);
+		return !desync_points.empty();
+	}
+
+	void Server::Handle(int client)
+	{
+		ServerClock::time_point start = ServerClock::now();
+
+		timeval timeout;
+		timeout.tv_sec = RECEIVE_TIMEOUT;
+		timeout.tv_usec = 0;
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+		std::vector<int> fds;
+		std::string response, out_data;
+		std::string name;
+		const wchar_t* status = L"ошибка";
+		bool cached = false;
+		try
+		{
+			std::string text;
+			Receive(client, text, fds);
+
+			Query request;
+			request.params = _params;
+			request.engine_name = _engine_name;
+			ParseRequest(text, request);
+			name = request.desync_fd >= 0 ? std::string("<fd>") : request.desync_name;
+
+			if (Process(request, fds, out_data, cached))
+			{
+				std::ostringstream oss;
+				oss << "OK " << out_data.size() << "\n";
+				response = oss.str();
+				status = L"синхронизирован";
+			}
+			else
+			{
+				std::ostringstream oss;
+				oss << "SYNC";
+				if (request.unchanged) oss << " " << out_data.size();
+				oss << "\n";
+				response = oss.str();
+				status = L"субтитры синхронны";
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::string message;
+			io::Encode(ErrorText(e), message);
+			response = "ERROR " + message + "\n";
+			out_data.clear();
+			if (_verbose) std::wclog << L"Ошибка: " << ErrorText(e) << std::endl;
+		}
+
+		for (std::vector<int>::const_iterator it = fds.begin(); it != fds.end(); ++it)
+		{
+			close(*it);
+		}
+
+		try
+		{
+			WriteAll(client, response.data(), response.size());
+			WriteAll(client, out_data.data(), out_data.size());
+		}
+		catch (const std::exception&)
+		{
+			// Клиент не дождался ответа
+		}
+
+		if (_verbose)
+		{
+			const double ms = boost::chrono::duration<double, boost::milli>(ServerClock::now() - start).count();
+			std::wclog << L"Запрос " << name.c_str() << L": " << status
+				<< (cached ? L", эталон из кэша" : L"") << L", " << ms << L" мс (кэш: " << _cache.hits << L"/" << (_cache.hits + _cache.misses) << L")" << std::endl;
+		}
+	}
+
+	void Serve(const std::string& socket_name, const KeywordFilter& keywords, unsigned long long keywords_hash, const SyncParams& params,
+		const std::string& engine_name, const EngineOptions& engine_options, bool verbose)
+	{
+		sockaddr_un address;
+		SocketAddress(socket_name, address);
+
+		Descriptor listener( socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) );
+		if (listener.get() < 0)
+		{
+			ThrowError("Can't create socket", L"Ошибка создания сокета");
+		}
+
+		// Сокет от завершившегося демона удаляется, от работающего - нет
+		{
+			Descriptor probe( socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) );
+			if (connect(probe.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+			{
+				ThrowError("Server already running", L"Демон на этом сокете уже запущен");
+			}
+			if (errno == ECONNREFUSED) unlink(socket_name.c_str());
+		}
+
+		// Только для текущего пользователя
+		const mode_t old_mask = umask(0077);
+		const int bound = bind(listener.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address));
+		umask(old_mask);
+		if (bound != 0 || listen(listener.get(), 16) != 0)
+		{
+			ThrowError("Can't bind socket", L"Ошибка открытия сокета");
+		}
+
+		// Без SA_RESTART, чтобы сигнал прерывал accept
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = OnStopSignal;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGINT, &action, nullptr);
+		sigaction(SIGTERM, &action, nullptr);
+		signal(SIGPIPE, SIG_IGN);
+
+		std::wclog << L"Ожидание запросов на \"" << socket_name.c_str() << L"\"" << std::endl;
+
+		Server server(keywords, keywords_hash, params, engine_name, engine_options, verbose);
+		while (!stop_requested)
+		{
+			Descriptor client( accept4(listener.get(), nullptr, nullptr, SOCK_CLOEXEC) );
+			if (client.get() < 0)
+			{
+				if (errno == EINTR || errno == ECONNABORTED) continue;
+				break;
+			}
+			server.Handle(client.get());
+		}
+
+		unlink(socket_name.c_str());
+	}
+
+	/**************/
+	/*   Клиент   */
+	/**************/
+	// Стандартный ввод передаётся демону копией дескриптора
+	static int OpenForRequest(const std::string& filename)
+	{
+		return io::IsStandardStream(filename) ? fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0) : open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+
+	bool Request(const std::string& socket_name, const std::string& sync_name, const std::string& desync_name,
+		const std::string& out_name, const SyncParams& params, const std::string& engine_name)
+	{
+		sockaddr_un address;
+		SocketAddress(socket_name, address);
+
+		Descriptor sync_fd( OpenForRequest(sync_name) );
+		Descriptor desync_fd( OpenForRequest(desync_name) );
+		if (sync_fd.get() < 0 || desync_fd.get() < 0)
+		{
+			ThrowError("Can't open file for reading", L"Ошибка открытия файла для чтения");
+		}
+
+		Descriptor connection( socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) );
+		if ( connection.get() < 0 || connect(connection.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 )
+		{
+			ThrowError("Can't connect to server", L"Ошибка подключения к демону");
+		}
+
+		std::ostringstream oss;
+		oss << "sync-fd 0\n" << "desync-fd 1\n"
+			<< "min-duration " << params.min_duration << "\n"
+			<< "max-offset " << params.max_offset << "\n"
+			<< "max-desync " << params.max_desync << "\n"
+			<< "max-shift " << params.max_shift << "\n"
+			<< "skip-lyrics " << params.skip_lyrics << "\n"
+			<< "no-skip " << params.no_skip << "\n"
+			<< "allow-overlap " << params.allow_overlap << "\n"
+			<< "engine " << engine_name << "\n"
+			<< "unchanged " << io::IsStandardStream(out_name) << "\n"
+			<< "\n";
+		const std::string text = oss.str();
+
+		// Дескрипторы уходят с первым байтом запроса
+		const int fds[2] = {sync_fd.get(), desync_fd.get()};
+		char control[CMSG_SPACE(sizeof(fds))];
+		memset(control, 0, sizeof(control));
+
+		iovec iov;
+		iov.iov_base = const_cast<char*>(text.data());
+		iov.iov_len = text.size();
+
+		msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = &iov;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+
+		cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+		memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+		ssize_t sent;
+		do
+		{
+			sent = sendmsg(connection.get(), &message, MSG_NOSIGNAL);
+		}
+		while (sent < 0 && errno == EINTR);
+		if (sent <= 0)
+		{
+			ThrowError("Socket write error", L"Ошибка записи в сокет");
+		}
+		WriteAll(connection.get(), text.data() + sent, text.size() - static_cast<size_t>(sent));
+
+		std::string response;
+		ReadDescriptor(connection.get(), response);
+		const size_t eol = response.find('\n');
+		const std::string status = response.substr(0, eol == std::string::npos ? 0 : eol);
+
+		if (status == "SYNC") return false;
+
+		if (status.compare(0, 6, "ERROR ") == 0)
+		{
+			std::wstring message;
+			io::Decode(status.data() + 6, status.size() - 6, message);
+			ThrowError("Server error", message);
+		}
+
+		// "SYNC <размер>" - ответ на unchanged: синхронный скрипт как есть
+		const bool in_sync = status.compare(0, 5, "SYNC ") == 0;
+		const size_t size_pos = in_sync ? 5 : 3;
+		if ( (!in_sync && status.compare(0, 3, "OK ") != 0) || response.size() - eol - 1 != strtoul(status.c_str() + size_pos, nullptr, 10) )
+		{
+			ThrowError("Wrong server response", L"Неправильный ответ демона");
+		}
+
+		// Как и обычный вывод: "-" - стандартный вывод, .gz и .zst сжимаются
+		io::OutputStream fout(out_name);
+		fout.Write(response.data() + eol + 1, response.size() - eol - 1);
+		fout.Close();
+		return !in_sync;
+	}
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include <string>
+
+#include "../filter.h"
+#include "../resync.h"
+#include "../engine.h"
+
+
+namespace server
+{
+	// Протокол: запрос - строки "ключ значение", завершённые пустой строкой.
+	//   sync <путь>, desync <путь> - скрипты по именам на стороне демона;
+	//     синхронизированным может быть и индекс (--write-index);
+	//   sync-fd <номер>, desync-fd <номер> - скрипты по дескрипторам, переданным через SCM_RIGHTS
+	//     вместе с запросом, номер - позиция дескриптора в сообщении;
+	//   min-duration, max-offset, max-desync, max-shift <число>, skip-lyrics, no-skip,
+	//   allow-overlap <0|1>, engine <название> - параметры, по умолчанию заданные демону;
+	//   unchanged <0|1> - вернуть и синхронный скрипт, как есть.
+	// Ответ: "OK <размер>\n" и синхронизированный скрипт в UTF-8, "SYNC\n", если субтитры
+	// уже синхронны ("SYNC <размер>\n" и скрипт при unchanged 1), или
+	// "ERROR <сообщение в UTF-8 с BOM>\n". После ответа соединение закрывается.
+
+	// Запросы обрабатываются по одному. Фильтр, алгоритмы сопоставления и группы
+	// последних синхронизированных скриптов остаются в памяти между запросами.
+	// Работает до SIGINT или SIGTERM. keywords_hash - таблица ключевых слов, как у индекса.
+	void Serve(const std::string& socket_name, const KeywordFilter& keywords, unsigned long long keywords_hash, const SyncParams& params,
+		const std::string& engine_name, const EngineOptions& engine_options, bool verbose);
+
+	// Передаёт демону дескрипторы скриптов и записывает ответ в out_name.
+	// false - субтитры синхронны; файл записан, только если это стандартный вывод.
+	bool Request(const std::string& socket_name, const std::string& sync_name, const std::string& desync_name,
+		const std::string& out_name, const SyncParams& params, const std::string& engine_name);
+}
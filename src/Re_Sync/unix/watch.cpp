@@ -0,0 +1,137 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "../exception.h"
+#include "watch.h"
+
+
+static volatile sig_atomic_t watch_stopped = 0;
+// Обработчик пишет в канал: сигнал между проверкой watch_stopped и poll
+// не потеряется, а poll проснётся, в каком бы потоке сигнал ни обработали
+static int watch_pipe[2] = {-1, -1};
+
+static void OnWatchStop(int)
+{
+	const int saved_errno = errno;
+	watch_stopped = 1;
+	const char byte = 0;
+	// Канал полон - значит, poll и так проснётся
+	const ssize_t written = write(watch_pipe[1], &byte, 1);
+	static_cast<void>(written);
+	errno = saved_errno;
+}
+
+static void ThrowWaitError()
+{
+	BOOST_THROW_EXCEPTION(
+		boost::enable_error_info(std::runtime_error("Can't wait for file changes"))
+		<< error_message(L"Ошибка ожидания изменения файла")
+	);
+}
+
+FileWatcher::FileWatcher(const std::string& filename, int debounce)
+	: _fd(-1), _debounce(debounce)
+{
+	const size_t slash = filename.rfind('/');
+	const std::string directory = slash == std::string::npos ? std::string(".") : (slash == 0 ? std::string("/") : filename.substr(0, slash));
+	_name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+
+	_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if ( _fd < 0 || inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0
+		|| (watch_pipe[0] < 0 && pipe2(watch_pipe, O_NONBLOCK | O_CLOEXEC) < 0) )
+	{
+		if (_fd >= 0) close(_fd);
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Can't watch directory"))
+			<< error_message(L"Ошибка слежения за каталогом файла")
+		);
+	}
+
+	// Канал живёт до конца процесса: обработчик остаётся установленным
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = OnWatchStop;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+}
+
+FileWatcher::~FileWatcher()
+{
+	close(_fd);
+}
+
+bool FileWatcher::ReadEvents()
+{
+	bool found = false;
+	char buffer[4096] __attribute__((aligned(__alignof__(inotify_event))));
+	for (;;)
+	{
+		const ssize_t count = read(_fd, buffer, sizeof(buffer));
+		if (count <= 0) break;
+		for (const char* p = buffer; p < buffer + count; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+			if (event->len > 0 && _name == event->name) found = true;
+			p += sizeof(inotify_event) + event->len;
+		}
+	}
+	return found;
+}
+
+bool FileWatcher::Wait()
+{
+	pollfd pfd[2];
+	pfd[0].fd = _fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = watch_pipe[0];
+	pfd[1].events = POLLIN;
+
+	// Первое событие с нашим файлом
+	bool changed = false;
+	while (!changed)
+	{
+		if (watch_stopped) return false;
+		pfd[0].revents = pfd[1].revents = 0;
+		const int ready = poll(pfd, 2, -1);
+		if (ready < 0 && errno != EINTR) ThrowWaitError();
+		if (ready > 0 && pfd[0].revents != 0) changed = ReadEvents();
+	}
+
+	// Пока события идут чаще debounce, сохранение не закончено
+	for (;;)
+	{
+		if (watch_stopped) return false;
+		pfd[0].revents = pfd[1].revents = 0;
+		const int ready = poll(pfd, 2, _debounce);
+		if (ready == 0) break;
+		if (ready < 0 && errno != EINTR) ThrowWaitError();
+		if (ready > 0 && pfd[0].revents != 0) ReadEvents();
+	}
+	return true;
+}
@@ -0,0 +1,32 @@
+﻿#pragma once
+
+#include <string>
+
+
+/*************************************/
+/*   Слежение за сохранением файла   */
+/*************************************/
+// Следит за каталогом файла через inotify, поэтому замечает и сохранение на месте,
+// и замену файла переименованием, как делают многие редакторы.
+class FileWatcher
+{
+public:
+	// debounce - сколько, мс, после последнего события ждать следующих,
+	// чтобы серия записей при одном сохранении дала одно срабатывание
+	explicit FileWatcher(const std::string& filename, int debounce = 50);
+	~FileWatcher();
+
+	// Ожидание сохранения; false - пришёл SIGINT или SIGTERM
+	bool Wait();
+
+private:
+	FileWatcher(const FileWatcher&);
+	FileWatcher& operator=(const FileWatcher&);
+
+	// true - в событиях есть наш файл
+	bool ReadEvents();
+
+	int _fd;
+	std::string _name;
+	int _debounce;
+};
@@ -26,16 +26,22 @@
 # endif
 #endif
 
+#include <cstdio>
 #include <cstring>
+#include <io.h>
+#include <fcntl.h>
 #include <locale>
+#include <iostream>
 #include <fstream>
 #include <sstream>
 #include <functional>
 #include <algorithm>
+#include <vector>
 #include <codecvt>
 
 #include "../nullptr.h"
 #include "../exception.h"
+#include "../hash.h"
 #include "io.h"
 
 
@@ -84,52 +90,243 @@ namespace io
 		size_t getBOMSize() { return _bom_size; }
 	};
 
+	typedef std::codecvt<wchar_t, char, mbstate_t> Codecvt;
+
+	// Сколько символов преобразуется за раз при записи
+	const size_t ENCODE_CHUNK = 1u << 12;
+
+	const char STANDARD_STREAM[] = "-";
+
+	bool IsStandardStream(const std::string& filename)
+	{
+		return filename == STANDARD_STREAM;
+	}
+
+	// zlib и zstd в проект не подключены: сжатые файлы не выдаются за текст
+	static void ThrowCompressed()
+	{
+		BOOST_THROW_EXCEPTION(
+			boost::enable_error_info(std::runtime_error("Compressed files not supported"))
+			<< error_message(L"Сжатые файлы не поддерживаются в Windows")
+		);
+	}
+
+	static bool IsCompressed(const std::string& data)
+	{
+		return data.compare(0, 2, "\x1F\x8B") == 0 || data.compare(0, 4, "\x28\xB5\x2F\xFD") == 0;
+	}
+
+	static bool EndsWith(const std::string& filename, const char* suffix)
+	{
+		const size_t size = strlen(suffix);
+		return filename.size() > size && filename.compare(filename.size() - size, size, suffix) == 0;
+	}
+
+	void Decompress(std::string& data)
+	{
+		if ( IsCompressed(data) ) ThrowCompressed();
+	}
+
 	/********************/
 	/*   Чтение файла   */
 	/********************/
+	void ReadData(const std::string& filename, std::string& data)
+	{
+		std::ostringstream oss;
+		if ( IsStandardStream(filename) )
+		{
+			// Иначе CRT заменит переводы строк и остановится на Ctrl+Z
+			_setmode(_fileno(stdin), _O_BINARY);
+			oss << std::cin.rdbuf();
+		}
+		else
+		{
+			std::ifstream fin(filename.c_str(), std::ios_base::binary);
+			fin.imbue(std::locale::classic());
+			if (!fin.is_open())
+			{
+				BOOST_THROW_EXCEPTION(
+					boost::enable_error_info(std::runtime_error("Сan't open file for reading"))
+					<< error_message(L"Ошибка открытия файла для чтения")
+				);
+			}
+			oss << fin.rdbuf();
+			fin.close();
+		}
+
+		data = oss.str();
+		Decompress(data);
+		if (data.size() < MAX_BOM)
+		{
+			BOOST_THROW_EXCEPTION(
+				boost::enable_error_info(std::runtime_error("File too small"))
+				<< error_message(L"Слишком маленький файл")
+			);
+		}
+	}
+
+	// Фасеты с consume_header не рассчитаны на преобразование по частям,
+	// поэтому текст преобразуется после чтения целиком
+	void ReadText(const std::string& filename, std::wstring& buffer, unsigned long long* hash, unsigned long long* size)
+	{
+		std::string data;
+		ReadData(filename, data);
+		if (hash != nullptr) *hash = XXHash64(data.data(), data.size());
+		if (size != nullptr) *size = data.size();
+		Decode(data.data(), data.size(), buffer);
+	}
+
 	void ReadFile(const std::string& filename, std::wstring& buffer)
 	{
-		wchar_t buf[MAX_BOM + 1u];
-		std::wifstream wfin(filename.c_str(), std::ios_base::binary);
-		wfin.imbue(std::locale::classic());
-		if (!wfin.is_open())
+		ReadText(filename, buffer);
+	}
+
+	/********************/
+	/*   Запись файла   */
+	/********************/
+	void WriteFile(const std::string& filename, const std::wstring& buffer, bool write_bom)
+	{
+		if ( EndsWith(filename, ".gz") || EndsWith(filename, ".zst") ) ThrowCompressed();
+
+		std::string data;
+		Encode(buffer, data, write_bom);
+
+		if ( IsStandardStream(filename) )
+		{
+			_setmode(_fileno(stdout), _O_BINARY);
+			std::cout.write(data.data(), data.size());
+			std::cout.flush();
+			return;
+		}
+
+		std::ofstream fout(filename.c_str(), std::ios_base::binary);
+		fout.imbue(std::locale::classic());
+		if (!fout.is_open())
+		{
+			BOOST_THROW_EXCEPTION(
+				boost::enable_error_info(std::runtime_error("Сan't open file for writing"))
+				<< error_message(L"Ошибка открытия файла для записи")
+			);
+		}
+
+		fout.write(data.data(), data.size());
+		fout.close();
+	}
+
+	/*********************/
+	/*   Потоки байтов   */
+	/*********************/
+	InputStream::InputStream(const std::string& filename) : _in(&std::cin), _first(true)
+	{
+		if ( IsStandardStream(filename) )
+		{
+			// Иначе CRT заменит переводы строк и остановится на Ctrl+Z
+			_setmode(_fileno(stdin), _O_BINARY);
+			return;
+		}
+
+		_fin.open(filename.c_str(), std::ios_base::binary);
+		if (!_fin.is_open())
 		{
 			BOOST_THROW_EXCEPTION(
 				boost::enable_error_info(std::runtime_error("Сan't open file for reading"))
 				<< error_message(L"Ошибка открытия файла для чтения")
 			);
 		}
+		_in = &_fin;
+	}
 
-		wfin.read(buf, MAX_BOM);
-		if (!wfin.good())
+	size_t InputStream::Read(char* data, size_t size)
+	{
+		_in->read(data, size);
+		if ( _in->bad() )
 		{
 			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("File too small"))
-				<< error_message(L"Слишком маленький файл")
+				boost::enable_error_info(std::runtime_error("File read error"))
+				<< error_message(L"Ошибка чтения файла")
 			);
 		}
-		wfin.seekg(0);
+		const size_t count = static_cast<size_t>(_in->gcount());
+		if (_first && IsCompressed( std::string(data, std::min<size_t>(count, 4u)) )) ThrowCompressed();
+		_first = false;
+		return count;
+	}
 
-		std::codecvt<wchar_t, char, mbstate_t>* facet = nullptr;
+	OutputStream::OutputStream(const std::string& filename) : _name(filename), _out(&std::cout), _closed(false)
+	{
+		if ( IsStandardStream(filename) )
+		{
+			_setmode(_fileno(stdout), _O_BINARY);
+			return;
+		}
+		if ( EndsWith(filename, ".gz") || EndsWith(filename, ".zst") ) ThrowCompressed();
+
+		_fout.open(filename.c_str(), std::ios_base::binary);
+		if (!_fout.is_open())
+		{
+			BOOST_THROW_EXCEPTION(
+				boost::enable_error_info(std::runtime_error("Сan't open file for writing"))
+				<< error_message(L"Ошибка открытия файла для записи")
+			);
+		}
+		_out = &_fout;
+	}
+
+	OutputStream::~OutputStream()
+	{
+		if (_closed || !_fout.is_open()) return;
+		_fout.close();
+		std::remove(_name.c_str());
+	}
+
+	void OutputStream::Write(const char* data, size_t size)
+	{
+		_out->write(data, size);
+	}
+
+	void OutputStream::Close()
+	{
+		_out->flush();
+		if (_fout.is_open()) _fout.close();
+		if (!*_out)
+		{
+			BOOST_THROW_EXCEPTION(
+				boost::enable_error_info(std::runtime_error("File write error"))
+				<< error_message(L"Ошибка записи файла")
+			);
+		}
+		_closed = true;
+	}
+
+	/**************************************/
+	/*   Преобразование текста в памяти   */
+	/**************************************/
+	void Decode(const char* data, size_t size, std::wstring& buffer)
+	{
+		// Байты начала как символы, как их читал поток с классической локалью
+		wchar_t buf[MAX_BOM + 1u] = {0};
+		for (size_t i = 0; i < MAX_BOM && i < size; ++i)
+		{
+			buf[i] = static_cast<unsigned char>(data[i]);
+		}
+
+		Codecvt* facet = nullptr;
 
 #if _MSC_VER >= 1600
 		// MSVC >= 2010
-		Codepage utf8(L"\xEF\xBB\xBF", new std::codecvt_utf8<wchar_t, 0x10ffffUL, std::consume_header>);
-		if (facet == nullptr && utf8.isMyBOM(buf))
+		if (facet == nullptr && Codepage(L"\xEF\xBB\xBF", nullptr).isMyBOM(buf))
 		{
-			facet = utf8.getFacet();
+			facet = new std::codecvt_utf8<wchar_t, 0x10ffffUL, std::consume_header>;
 		}
 
-		Codepage utf16le(L"\xFF\xFE", new std::codecvt_utf16<wchar_t, 0x10ffffUL, std::codecvt_mode(std::little_endian | std::consume_header)>);
-		if (facet == nullptr && utf16le.isMyBOM(buf))
+		if (facet == nullptr && Codepage(L"\xFF\xFE", nullptr).isMyBOM(buf))
 		{
-			facet = utf16le.getFacet();
+			facet = new std::codecvt_utf16<wchar_t, 0x10ffffUL, std::codecvt_mode(std::little_endian | std::consume_header)>;
 		}
-		
-		Codepage utf16be(L"\xFE\xFF", new std::codecvt_utf16<wchar_t, 0x10ffffUL, std::consume_header>);
-		if (facet == nullptr && utf16be.isMyBOM(buf))
+
+		if (facet == nullptr && Codepage(L"\xFE\xFF", nullptr).isMyBOM(buf))
 		{
-			facet = utf16be.getFacet();
+			facet = new std::codecvt_utf16<wchar_t, 0x10ffffUL, std::consume_header>;
 		}
 #endif
 
@@ -146,44 +343,31 @@ namespace io
 			);
 		}
 
-		wfin.imbue(std::locale(std::locale::classic(), facet));
+		// Локаль владеет фасетом
+		std::locale locale(std::locale::classic(), facet);
+		const Codecvt& cvt = std::use_facet<Codecvt>(locale);
 
-		std::wostringstream woss;
-		woss << wfin.rdbuf();
-		wfin.close();
+		// Символов не больше, чем байт. Как и при чтении потоком, на ошибке текст обрывается.
+		std::vector<wchar_t> out(size + 1u);
+		mbstate_t state = mbstate_t();
+		const char* from_next = nullptr;
+		wchar_t* to_next = nullptr;
+		cvt.in(state, data, data + size, from_next, &out[0], &out[0] + out.size(), to_next);
 
-		woss.str().swap(buffer);
+		buffer.assign(&out[0], to_next);
 	}
 
-	/********************/
-	/*   Запись файла   */
-	/********************/
-	void WriteFile(const std::string& filename, const std::wstring& buffer, bool write_bom)
+	void Encode(const std::wstring& buffer, std::string& data, bool write_bom)
 	{
-		std::wofstream wfout(filename.c_str(), std::ios_base::binary);
-		if (!wfout.is_open())
-		{
-			BOOST_THROW_EXCEPTION(
-				boost::enable_error_info(std::runtime_error("Сan't open file for writing"))
-				<< error_message(L"Ошибка открытия файла для записи")
-			);
-		}
-
-		std::codecvt<wchar_t, char, mbstate_t>* facet = nullptr;
+		Codecvt* facet = nullptr;
 
 #if _MSC_VER >= 1600
 		// MSVC >= 2010
-		if (write_bom)
-		{
-			facet = new std::codecvt_utf8<wchar_t, 0x10ffffUL, std::generate_header>;
-		}
-		else
-		{
-			facet = new std::codecvt_utf8<wchar_t>;
-		}
+		facet = new std::codecvt_utf8<wchar_t>;
 #elif _MSC_VER >= 1310
 		// MSVC >= 2003
 		facet = new std::codecvt_byname<wchar_t, char, mbstate_t>(std::locale(".ACP").name());
+		write_bom = false;
 #endif
 
 		if (facet == nullptr)
@@ -193,10 +377,32 @@ namespace io
 				<< error_message(L"Ошибка преобразования кодировки")
 			);
 		}
-		
-		wfout.imbue(std::locale(std::locale::classic(), facet));
 
-		wfout << buffer;
-		wfout.close();
+		std::locale locale(std::locale::classic(), facet);
+		const Codecvt& cvt = std::use_facet<Codecvt>(locale);
+
+		data.clear();
+		if (write_bom) data.append("\xEF\xBB\xBF", 3);
+
+		std::vector<char> out(ENCODE_CHUNK * cvt.max_length());
+		mbstate_t state = mbstate_t();
+		const wchar_t* from = buffer.data();
+		const wchar_t* const end = buffer.data() + buffer.size();
+		while (from != end)
+		{
+			const wchar_t* from_next = nullptr;
+			char* to_next = nullptr;
+			std::codecvt_base::result result = cvt.out(state, from, std::min(from + ENCODE_CHUNK, end), from_next, &out[0], &out[0] + out.size(), to_next);
+			if (result == std::codecvt_base::error || from_next == from)
+			{
+				BOOST_THROW_EXCEPTION(
+					boost::enable_error_info(std::runtime_error("Can't convert encoding"))
+					<< error_message(L"Ошибка преобразования кодировки")
+				);
+			}
+
+			data.append(&out[0], to_next);
+			from = from_next;
+		}
 	}
 }
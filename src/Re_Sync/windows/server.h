@@ -0,0 +1,17 @@
+﻿#pragma once
+
+#include <string>
+
+#include "../filter.h"
+#include "../resync.h"
+#include "../engine.h"
+
+
+namespace server
+{
+	// Демон на локальном сокете есть только в unix-версии
+	void Serve(const std::string& socket_name, const KeywordFilter& keywords, unsigned long long keywords_hash, const SyncParams& params,
+		const std::string& engine_name, const EngineOptions& engine_options, bool verbose);
+	bool Request(const std::string& socket_name, const std::string& sync_name, const std::string& desync_name,
+		const std::string& out_name, const SyncParams& params, const std::string& engine_name);
+}
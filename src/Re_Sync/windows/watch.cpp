@@ -0,0 +1,44 @@
+﻿/*******************************************************************************
+ * This file is part of Re_Sync.
+ *
+ * Copyright (C) 2011  Andrey Efremov <duxus@yandex.ru>
+ *
+ * Re_Sync is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Re_Sync is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Re_Sync.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#if defined _MSC_VER && _MSC_VER >= 1400
+# ifndef _SCL_SECURE_NO_WARNINGS
+#  define _SCL_SECURE_NO_WARNINGS
+# endif
+# ifndef _CRT_SECURE_NO_WARNINGS
+#  define _CRT_SECURE_NO_WARNINGS
+# endif
+#endif
+
+#include "../exception.h"
+#include "watch.h"
+
+
+FileWatcher::FileWatcher(const std::string&, int)
+{
+	BOOST_THROW_EXCEPTION(
+		boost::enable_error_info(std::runtime_error("File watching is not supported on Windows"))
+		<< error_message(L"Слежение за файлом не поддерживается в Windows")
+	);
+}
+
+bool FileWatcher::Wait()
+{
+	return false;
+}
@@ -0,0 +1,16 @@
+﻿#pragma once
+
+#include <string>
+
+
+// Слежение за файлом есть только в unix-версии
+class FileWatcher
+{
+public:
+	explicit FileWatcher(const std::string& filename, int debounce = 50);
+	bool Wait();
+
+private:
+	FileWatcher(const FileWatcher&);
+	FileWatcher& operator=(const FileWatcher&);
+};